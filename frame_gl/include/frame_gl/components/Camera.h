@@ -21,11 +21,11 @@ namespace frame
 
     public:
         Camera(unsigned int layer=0, float vertical_fov=120.0f, float aspect_ratio=1.0f, float clip_near=0.1f, float clip_far=2000.0f)
-        : _type(Perspective), _layer_mask(1 << layer), _settings({ vertical_fov, aspect_ratio, clip_near, clip_far, vec2(0.0f), vec2(0.0f) }) { update_matrix(); }
+        : _type(Perspective), _layer_mask(1 << layer), _version(0), _settings({ vertical_fov, aspect_ratio, clip_near, clip_far, vec2(0.0f), vec2(0.0f) }) { update_matrix(); }
         Camera(unsigned int layer, const vec2& ortho_size, float clip_near=0.0f, float clip_far=2000.0f)
-        : _type(Orthographic), _layer_mask(1 << layer), _settings({ 0.0f, 0.0f, clip_near, clip_far, vec2(-ortho_size * 0.5f), vec2(ortho_size * 0.5f) }) { update_matrix(); }
+        : _type(Orthographic), _layer_mask(1 << layer), _version(0), _settings({ 0.0f, 0.0f, clip_near, clip_far, vec2(-ortho_size * 0.5f), vec2(ortho_size * 0.5f) }) { update_matrix(); }
         Camera(unsigned int layer, const vec2& ortho_topleft, const vec2& ortho_bottomright, float clip_near=0.0f, float clip_far=2000.0f)
-        : _type(Orthographic), _layer_mask(1 << layer), _settings({ 0.0f, 0.0f, clip_near, clip_far, ortho_topleft, ortho_bottomright }) { update_matrix(); }
+        : _type(Orthographic), _layer_mask(1 << layer), _version(0), _settings({ 0.0f, 0.0f, clip_near, clip_far, ortho_topleft, ortho_bottomright }) { update_matrix(); }
 
     public:
 
@@ -77,28 +77,35 @@ namespace frame
         }
 
         unsigned int layer_mask() { return _layer_mask; }
+
+        /// \brief Incremented whenever the projection or layers of this camera change.
+        unsigned int version() const { return _version; }
         bool has_layer(unsigned int layer) { return (_layer_mask & (1 << layer)) != 0; }
 
         template<typename... Layers>
         Camera* set_layers(Layers... layers) {
             _layer_mask = 0;
+            ++_version;
             add_layer(layers)...;
             return this;
         }
 
         Camera* add_layer(unsigned int layer) {
             _layer_mask |= (1 << layer);
+            ++_version;
             return this;
         }
 
         Camera* remove_layer(unsigned int layer) {
             _layer_mask &= ~(1 << layer);
+            ++_version;
             return this;
         }
 
     private:
 
         void update_matrix() {
+            ++_version;
             if (_type == Perspective)
                 _projection_matrix = glm::perspective(
                     _settings.vertical_fov,
@@ -117,6 +124,7 @@ namespace frame
         Type _type;
         Settings _settings;
         unsigned int _layer_mask;
+        unsigned int _version;
         mat4 _projection_matrix;
         vec3 _direction;
     };
@@ -12,6 +12,8 @@
 
 namespace frame
 {
+    class Render;
+
     FRAME_COMPONENT(MeshRenderer, Transform) {
     public:
         enum PolyMode {
@@ -20,10 +22,23 @@ namespace frame
             Point = GL_POINT
         };
 
+        /// \brief How a mesh is combined with what's already in the target. Only Opaque meshes
+        ///        write depth, and blending is only ever enabled for the others.
+        enum BlendMode {
+            Opaque,
+            Alpha,
+            Additive,
+            Premultiplied
+        };
+
     public:
-        MeshRenderer() : _mesh(MeshFactory::cube()), _texture(Texture::white_pixel()), _shader(Shader::Preset::model_colors()), _poly_mode(Fill), _cull_back(true), _layer(0) {}
+        MeshRenderer() : _mesh(MeshFactory::cube()), _texture(Texture::white_pixel()), _shader(Shader::Preset::model_colors()), _poly_mode(Fill), _cull_back(true), _layer(0), _occluder(false), _blend_mode(Opaque), _render(nullptr), _bucket_index(0) {}
         MeshRenderer(Resource<Mesh> mesh, Resource<Texture> texture, Resource<Shader> shader, PolyMode poly_mode=Fill, bool cull_back=true, unsigned int layer=0)
-        : _mesh(mesh), _texture(texture), _shader(shader), _poly_mode(poly_mode), _cull_back(cull_back), _layer(layer) {}
+        : _mesh(mesh), _texture(texture), _shader(shader), _poly_mode(poly_mode), _cull_back(cull_back), _layer(layer), _occluder(false), _blend_mode(Opaque), _render(nullptr), _bucket_index(0) {}
+
+    protected:
+        void setup(FrameInterface& frame, Entity* entity);
+        void teardown(FrameInterface& frame, Entity* entity);
 
     public:
 
@@ -36,21 +51,20 @@ namespace frame
         void bind(Camera* camera) const {
 
             // Set GL state
-            glPolygonMode(GL_FRONT_AND_BACK, _poly_mode);
-            if (_cull_back) glEnable(GL_CULL_FACE);
-            else glDisable(GL_CULL_FACE);
-
-            // Get transformation matrices
-            auto model = get<Transform>()->world_matrix();
-            auto view = camera->view_matrix();
-            auto projection = camera->projection_matrix();
+            bind_state(_poly_mode, _cull_back, _blend_mode);
 
             // Bind stuff
             _texture->bind(0);
             _shader->bind();
-            _shader->uniform(ShaderUniform::Model, model);
-            _shader->uniform(ShaderUniform::View, view);
-            _shader->uniform(ShaderUniform::Projection, projection);
+
+            // Matrices come from the Camera and Object uniform blocks, but
+            // shaders which still declare them as loose uniforms get them here.
+            if (_shader->uniforms().model != -1)
+                _shader->uniform(ShaderUniform::Model, get<Transform>()->world_matrix());
+            if (_shader->uniforms().view != -1)
+                _shader->uniform(ShaderUniform::View, camera->view_matrix());
+            if (_shader->uniforms().projection != -1)
+                _shader->uniform(ShaderUniform::Projection, camera->projection_matrix());
         }
 
         void render(Camera* camera) const {
@@ -62,35 +76,89 @@ namespace frame
         void unbind() const {
             _shader->unbind();
             _texture->unbind();
+            unbind_state(_blend_mode);
+        }
+
+        /// \brief Set the GL state for drawing in the given modes. Render uses this to replay
+        ///        draws it recorded from renderers earlier in the frame.
+        static void bind_state(PolyMode poly_mode, bool cull_back, BlendMode blend_mode) {
+            glPolygonMode(GL_FRONT_AND_BACK, poly_mode);
+            if (cull_back) glEnable(GL_CULL_FACE);
+            else glDisable(GL_CULL_FACE);
+
+            // Targets are bound with blending off, so opaque meshes never pay for it
+            if (blend_mode != Opaque) {
+                glEnable(GL_BLEND);
+                if (blend_mode == Alpha) glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                else if (blend_mode == Additive) glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+                else glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            }
+        }
+
+        static void unbind_state(BlendMode blend_mode) {
+            if (blend_mode != Opaque)
+                glDisable(GL_BLEND);
         }
 
     public:
         MeshRenderer* set_shader(Resource<Shader> shader) { _shader = shader; return this; }
-        MeshRenderer* set_layer(unsigned int layer) { _layer = layer; return this; }
+        MeshRenderer* set_layer(unsigned int layer);
+
+        /// \brief Mark this mesh as an occluder, to be rasterized into the Render system's
+        ///        occlusion buffer. Only large, simple meshes (walls, floors) are worth it.
+        MeshRenderer* set_occluder(bool occluder) { _occluder = occluder; return this; }
+
+        /// \brief Set how this mesh is blended. Blended meshes are drawn after all opaque meshes,
+        ///        back to front, without writing depth.
+        MeshRenderer* set_blend_mode(BlendMode blend_mode) { _blend_mode = blend_mode; return this; }
 
     public:
         Resource<Mesh> mesh() { return _mesh; }
         Resource<Texture> texture() { return _texture; }
         Resource<Shader> shader() { return _shader; }
         unsigned int layer() { return _layer; }
+        PolyMode poly_mode() const { return _poly_mode; }
+        bool cull_back() const { return _cull_back; }
+        bool occluder() const { return _occluder; }
+        BlendMode blend_mode() const { return _blend_mode; }
+        bool blended() const { return _blend_mode != Opaque; }
 
     protected:
+        /// \brief The layout version written ahead of the rest, negated so it can't be mistaken
+        ///        for the polygon mode older archives start with. Version 2 added the occluder
+        ///        flag and the blend mode.
+        static const int ARCHIVE_VERSION = 2;
+
         void write(Archive& archive) {
+            archive.write<int>(-ARCHIVE_VERSION);
             archive.write<int>(_poly_mode);
             archive.write(_cull_back);
             archive.write(_layer);
             archive.write(_mesh.index());
             archive.write(_texture.index());
             archive.write(_shader.index());
+            archive.write(_occluder);
+            archive.write<int>(_blend_mode);
         }
 
         void read(Archive& archive) {
+
+            // Archives from before the version was written start with the polygon mode, which is never negative
+            int version = 1;
             int poly_mode_int;
             archive.read<int>(poly_mode_int);
+            if (poly_mode_int < 0) {
+                version = -poly_mode_int;
+                archive.read<int>(poly_mode_int);
+            }
             _poly_mode = (PolyMode)poly_mode_int;
 
             archive.read(_cull_back);
-            archive.read(_layer);
+
+            // Through set_layer, so a renderer which is already registered changes buckets
+            unsigned int layer;
+            archive.read(layer);
+            set_layer(layer);
 
             // Load the body and shape resources.
             size_t mesh_index, texture_index, shader_index;
@@ -100,8 +168,20 @@ namespace frame
             _mesh.lookup(mesh_index);
             _texture.lookup(texture_index);
             _shader.lookup(shader_index);
+
+            if (version < 2)
+                return;
+
+            archive.read(_occluder);
+
+            int blend_mode_int;
+            archive.read<int>(blend_mode_int);
+            _blend_mode = (BlendMode)blend_mode_int;
         }
 
+    private:
+        friend class Render;
+
     private:
         Resource<Mesh> _mesh;
         Resource<Texture> _texture;
@@ -109,5 +189,9 @@ namespace frame
         PolyMode _poly_mode;
         bool _cull_back;
         unsigned int _layer;
+        bool _occluder;
+        BlendMode _blend_mode;
+        Render* _render;
+        size_t _bucket_index;
     };
 }
\ No newline at end of file
@@ -9,11 +9,20 @@ namespace frame
 {
     FRAME_COMPONENT(RenderTarget) {
     public:
-        RenderTarget(const ivec2& size=ivec2(300), int display_layer=-1, bool depth=true, const vec4& clear_color=vec4(0.0f)) :
-            _display_layer(display_layer), _display_priority(display_layer), buffer(Resource<FrameBuffer>(size, depth, clear_color)) {}
+        /// \brief When Render should redraw a target with a camera. OnChange redraws only when the
+        ///        camera, or any renderer, transform or mesh on its layers has changed, and Interval
+        ///        redraws once every redraw_interval() frames, or sooner once invalidated.
+        enum Redraw { Always, OnChange, Interval };
+
+    public:
+        RenderTarget(const ivec2& size=ivec2(300), int display_layer=-1, bool depth=true, const vec4& clear_color=vec4(0.0f),
+                     Texture::Format color_format=Texture::RGBA32F, FrameBuffer::DepthFormat depth_format=FrameBuffer::Depth24) :
+            _display_layer(display_layer), _display_priority(display_layer), buffer(Resource<FrameBuffer>(size, depth, clear_color, false, color_format, depth_format)),
+            _redraw(Always), _redraw_interval(1), _frames_since_redraw(0), _signature(0), _dirty(true), _redrawn(true), _dynamic_resolution(false), _render_scale(1.0f) {}
 
         RenderTarget(const Resource<FrameBuffer>& buffer, int display_layer=-1) :
-            _display_layer(display_layer), _display_priority(display_layer), buffer(buffer) {}
+            _display_layer(display_layer), _display_priority(display_layer), buffer(buffer),
+            _redraw(Always), _redraw_interval(1), _frames_since_redraw(0), _signature(0), _dirty(true), _redrawn(true), _dynamic_resolution(false), _render_scale(buffer->render_scale()) {}
 
         ~RenderTarget() {}
 
@@ -24,6 +33,12 @@ namespace frame
         void unbind_texture() { buffer->unbind_texture(); }
         void unbind_target() { buffer->unbind_target(); }
 
+        /// \brief Read the target's pixels back without stalling. The callback runs on the GL thread
+        ///        a few frames later, once Render finds the GPU has finished the copy.
+        void read_async(const FrameBuffer::ReadCallback& callback) { buffer->read_async(callback); }
+        void poll_reads() { buffer->poll_reads(); }
+        void finish_reads() { buffer->finish_reads(); }
+
         /*
         void set_display_layer(int display_layer) {
             //
@@ -41,9 +56,76 @@ namespace frame
 
         RenderTarget* set_size(const ivec2& size) {
             buffer->set_size(size);
+            _dirty = true;
+            return this;
+        }
+
+        /// \brief Render to a scaled-down part of the target. The Window scales it back up to fill
+        ///        the whole target when compositing. The new scale takes effect at the start of
+        ///        Render's next step, once the last frame's passes have finished with the target.
+        RenderTarget* set_render_scale(float render_scale) {
+            _render_scale = glm::clamp(render_scale, 0.0f, 1.0f);
+            return this;
+        }
+
+        /// \brief Called by Render when no passes are in flight, to apply set_render_scale().
+        void apply_render_scale() {
+            if (_render_scale != buffer->render_scale()) {
+                buffer->set_render_scale(_render_scale);
+                _dirty = true;
+            }
+        }
+
+        /// \brief Let the DynamicResolution system pick this target's render scale.
+        RenderTarget* set_dynamic_resolution(bool dynamic_resolution) {
+            _dynamic_resolution = dynamic_resolution;
+            return this;
+        }
+
+        RenderTarget* set_redraw(Redraw redraw, unsigned int interval=1) {
+            _redraw = redraw;
+            _redraw_interval = interval > 0 ? interval : 1;
+            return this;
+        }
+
+        /// \brief Force the next frame to redraw this target, for changes Render can't track
+        ///        itself, like the contents of a texture drawn to it.
+        RenderTarget* invalidate() {
+            _dirty = true;
             return this;
         }
 
+        /// \brief Called by Render once per frame with a signature of everything which would be drawn.
+        /// \return true if the target should be cleared and redrawn.
+        bool should_redraw(size_t signature) {
+            bool changed = _dirty || signature != _signature;
+            _signature = signature;
+            ++_frames_since_redraw;
+
+            bool redraw =
+                _redraw == Always ||
+                (_redraw == OnChange && changed) ||
+                (_redraw == Interval && (_dirty || _frames_since_redraw >= _redraw_interval));
+
+            if (redraw) {
+                _frames_since_redraw = 0;
+                _dirty = false;
+            }
+            _redrawn = redraw;
+            return redraw;
+        }
+
+        /// \brief Called by systems which draw over the target after Render, with whether they have
+        ///        anything to draw. An overlay stays on the target until it's cleared, so the
+        ///        target is redrawn the frame after any overlay, and overlays are only drawn on
+        ///        frames where Render has just redrawn it.
+        /// \return true if the overlay should be drawn this frame.
+        bool prepare_overlay(bool content) {
+            if (content)
+                _dirty = true;
+            return _redrawn;
+        }
+
         RenderTarget* set_display_priority(int display_priority) {
             _display_priority = display_priority;
             return this;
@@ -52,8 +134,20 @@ namespace frame
         int display_layer() const { return _display_layer; }
         int display_priority() const { return _display_priority; }
         const ivec2& size() const { return buffer->size(); }
+        ivec2 viewport() const { return buffer->viewport(); }
+        const ivec2& allocation() const { return buffer->allocation(); }
+        float render_scale() const { return _render_scale; }
+        bool dynamic_resolution() const { return _dynamic_resolution; }
         const vec4& clear_color() const { return buffer->clear_color(); }
         bool depth() const { return buffer->depth(); }
+        bool multisample() const { return buffer->multisample(); }
+        Texture::Format color_format() const { return buffer->color_format(); }
+        FrameBuffer::DepthFormat depth_format() const { return buffer->depth_format(); }
+
+        /// \brief The frame buffer behind this target, for declaring render graph passes on it.
+        FrameBuffer* frame_buffer() const { return buffer.operator->(); }
+        Redraw redraw() const { return _redraw; }
+        unsigned int redraw_interval() const { return _redraw_interval; }
 
     public:
 
@@ -66,5 +160,13 @@ namespace frame
         int _display_layer;
         int _display_priority;
         Resource<FrameBuffer> buffer;
+        Redraw _redraw;
+        unsigned int _redraw_interval;
+        unsigned int _frames_since_redraw;
+        size_t _signature;
+        bool _dirty;
+        bool _redrawn;
+        bool _dynamic_resolution;
+        float _render_scale;
     };
 }
\ No newline at end of file
@@ -43,7 +43,7 @@ namespace frame
 
     public:
         Transform(const vec3& translation=vec3(0.0f), const quat& rotation=quat(), const vec3& scale=vec3(1.0f))
-            : local({ translation, rotation, scale }), _valid(0) {}
+            : local({ translation, rotation, scale }), _valid(0), _version(0) {}
 
     public:
 
@@ -210,6 +210,9 @@ namespace frame
             return world;
         }
 
+        /// \brief Incremented whenever this transform or any of its parents changes.
+        unsigned int version() const { return _version; }
+
         /// \brief Returns true if all of the given flags are on
         inline bool valid(int flags) const { return (_valid & flags) == flags; }
 
@@ -221,6 +224,7 @@ namespace frame
 
         inline void invalidate(int flags) {
             _valid &= ~flags;
+            ++_version;
             for (Transform* child : children())
                 child->invalidate(ALL_WORLD);
         }
@@ -233,5 +237,6 @@ namespace frame
         mutable mat4 _world_matrix;
         mutable mat4 _world_inverse;
         mutable int _valid;
+        unsigned int _version;
     };
 }
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace frame
+{
+    /// \brief Check whether any GL context is current on this thread, whether it was made by a
+    ///        Window through GLFW or by the Headless system through EGL.
+    bool gl_context_current();
+}
@@ -1,35 +1,127 @@
 #pragma once
 #include <memory>
+#include <functional>
+#include <deque>
+#include <vector>
 #include "frame_gl/math.h"
 #include "frame_gl/data/Texture.h"
 
 namespace frame {
     class FrameBuffer {
     public:
-        FrameBuffer(const ivec2& size, bool depth=true, const vec4& clear_color=vec4(0.0f), bool multisample=false);
+        /// \brief Receives the pixels of an asynchronous read, as tightly packed RGBA8 rows from the bottom up.
+        typedef std::function<void (const ivec2& /*size*/, const std::vector<unsigned char>& /*pixels*/)> ReadCallback;
+
+        /// \brief Number of reads which may be in flight at once.
+        static const unsigned int READ_BUFFERS = 3;
+
+        /// \brief Formats for the depth buffer, which is only created if depth is enabled.
+        enum DepthFormat { Depth16, Depth24, Depth32F, Depth24Stencil8, Depth32FStencil8 };
+
+    public:
+        FrameBuffer(const ivec2& size, bool depth=true, const vec4& clear_color=vec4(0.0f), bool multisample=false,
+                    Texture::Format color_format=Texture::RGBA32F, DepthFormat depth_format=Depth24);
         ~FrameBuffer();
         FrameBuffer(const FrameBuffer& frame_buffer) = delete;
         FrameBuffer& operator=(const FrameBuffer& frame_buffer) = delete;
 
     public:
+        /// \brief Change the size of the buffer. Shrinking a little, and growing back to a size it
+        ///        has held before, just draws to less of the existing storage. Storage is only given
+        ///        back once it has more than twice the area the buffer needs.
         void set_size(const ivec2& size);
+
+        /// \brief The storage set_size() leaves a buffer with, given the storage it has now.
+        ///        Grows to fit, and shrinks to the size exactly once more than half would go unused.
+        static ivec2 fit_allocation(const ivec2& allocation, const ivec2& size) {
+            ivec2 fit = allocation;
+            if (size.x > fit.x || size.y > fit.y)
+                fit = max(size, fit);
+            if (size.x > 0 && size.y > 0 && 2 * size.x * size.y < fit.x * fit.y)
+                fit = size;
+            return fit;
+        }
+
+        /// \brief Reallocate the storage to fit the current size exactly.
+        void trim();
+
         void set_clear_color(const vec3& clear_color) { _clear_color = vec4(clear_color, 1.0f); }
         void set_clear_color(const vec4& clear_color) { _clear_color = clear_color; }
+
+        /// \brief Draw to a sub-rectangle of the buffer, scaled from its size, so the
+        ///        resolution can change every frame without reallocating anything.
+        void set_render_scale(float render_scale) { _render_scale = glm::clamp(render_scale, 0.0f, 1.0f); }
+
         void bind_target(bool clear=false);
+
+        /// \brief Put back the state bind_target() leaves, for passes which share a bind.
+        ///        The frame buffer must already be bound.
+        void reset_state(bool clear=false);
+
         void bind_texture(unsigned int texture_unit);
         void unbind_target();
         void unbind_texture();
+
+        /// \brief Copy the rendered part of the buffer, which is viewport pixels in size, over the
+        ///        whole of the window's default frame buffer, scaling it if the sizes differ.
+        ///        Multisampled buffers are resolved on the way, which GL only allows when the sizes match.
+        void blit_to_screen(const ivec2& viewport, const ivec2& screen_size);
+
+        /// \brief Copy the rendered part of the buffer into the corner of another buffer with the
+        ///        same color format, resolving it if it's multisampled. The other buffer is left bound.
+        void resolve_to(FrameBuffer* target, const ivec2& viewport);
+
+        /// \brief Copy the viewport of the color buffer into a pixel buffer object without waiting for the GPU, and
+        ///        hand the pixels to the callback from a later poll_reads() once they've arrived.
+        ///        If every buffer of the ring is still in flight, this waits for the oldest.
+        void read_async(const ReadCallback& callback);
+
+        /// \brief Deliver every read the GPU has finished, in the order they were made.
+        void poll_reads();
+
+        /// \brief Wait for and deliver every read still in flight.
+        void finish_reads();
+
+        size_t pending_reads() const { return reads.size(); }
         const ivec2& size() const { return _size; }
+        const ivec2& allocation() const { return _allocation; }
+        float render_scale() const { return _render_scale; }
+        ivec2 viewport() const { return max(ivec2(1), ivec2(vec2(_size) * _render_scale + 0.5f)); }
         bool depth() const { return _depth; }
+        bool multisample() const { return _multisample; }
+        bool stencil() const { return _depth && (_depth_format == Depth24Stencil8 || _depth_format == Depth32FStencil8); }
+        Texture::Format color_format() const { return _color_format; }
+        DepthFormat depth_format() const { return _depth_format; }
         const vec4& clear_color() const { return _clear_color; }
 
+    private:
+        void allocate(const ivec2& allocation);
+        void allocate_depth();
+
+        struct Read {
+            unsigned int buffer;
+            void* fence;
+            ivec2 size;
+            ReadCallback callback;
+        };
+
+        void deliver(Read& read);
+
     private:
         ivec2 _size;
+        ivec2 _allocation;
         bool _multisample;
         bool _depth;
+        Texture::Format _color_format;
+        DepthFormat _depth_format;
         vec4 _clear_color;
+        float _render_scale;
         Texture* texture;
         unsigned int frame_buffer_id;
         unsigned int depth_buffer_id;
+        std::vector<unsigned int> read_buffers;
+        std::deque<Read> reads;
+        unsigned int next_read;
+        std::vector<unsigned char> read_pixels;
     };
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "frame_gl/data/FrameBuffer.h"
+#include "frame_gl/data/Texture.h"
+#include "frame_gl/math.h"
+
+namespace frame
+{
+    /// \class FrameBufferPool
+    /// \brief Hands out frame buffers for intermediate passes which only need them for part of a frame.
+    ///
+    /// A buffer given back with release() is handed straight to the next acquire() with the same
+    /// formats whose size fits in its storage, so passes which don't overlap end up sharing the
+    /// same memory, even within a single frame. GL can't alias the storage of different formats,
+    /// so that's as far as aliasing goes. Buffers which sit unused for a few frames are deleted.
+    class FrameBufferPool {
+    public:
+        FrameBufferPool(unsigned int max_idle_frames=3) : frame(0), max_idle_frames(max_idle_frames) {}
+        ~FrameBufferPool() { clear(); }
+        FrameBufferPool(const FrameBufferPool& other) = delete;
+        FrameBufferPool& operator=(const FrameBufferPool& other) = delete;
+
+    public:
+
+        /// \brief Take a buffer of at least the given size out of the pool, making one if none fit.
+        ///        Its contents are undefined, so it should be cleared when bound.
+        FrameBuffer* acquire(const ivec2& size, Texture::Format format=Texture::RGBA8, bool depth=false, FrameBuffer::DepthFormat depth_format=FrameBuffer::Depth24);
+
+        /// \brief Give a buffer back for later passes to use.
+        void release(FrameBuffer* buffer);
+
+        /// \brief Delete buffers which haven't been used for a while. Called once a frame.
+        void next_frame();
+
+        /// \brief Delete every buffer, whether it's in use or not.
+        void clear();
+
+        size_t allocated() const { return entries.size(); }
+        size_t in_use() const;
+
+    private:
+        struct Entry {
+            FrameBuffer* buffer;
+            bool in_use;
+            unsigned int last_used;
+        };
+
+    private:
+        std::vector<Entry> entries;
+        unsigned int frame;
+        unsigned int max_idle_frames;
+    };
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace frame
+{
+    /// \class GpuProfiler
+    /// \brief Times named spans of each frame on both the CPU and the GPU, without stalling.
+    ///
+    /// begin() and end() drop GL timestamp queries into the command stream around a span of work.
+    /// Each span keeps a ring of query pairs, one per frame in flight, and next_frame() reads back
+    /// the pair written FRAMES - 1 frames ago, by which time the GPU has almost always finished with it.
+    /// Results which still aren't available are dropped rather than waited for. Timings are
+    /// smoothed into rolling averages, in milliseconds.
+    ///
+    /// begin(), end() and next_frame() must come from the GL thread, which may be the render
+    /// thread. The timings can be read from any thread.
+    class GpuProfiler {
+    public:
+        static const unsigned int FRAMES = 3;
+
+        struct Timing {
+            double cpu_ms;
+            double gpu_ms;
+            size_t samples;
+            size_t frame;   ///< The last frame whose GPU time was read back.
+        };
+
+    public:
+        /// \brief The profiler shared by every system.
+        static GpuProfiler& get();
+
+        GpuProfiler(const GpuProfiler& other) = delete;
+        GpuProfiler& operator=(const GpuProfiler& other) = delete;
+
+    public:
+
+        /// \brief Start timing a span. Each name may only be open once at a time.
+        void begin(const std::string& name);
+
+        /// \brief Stop timing a span.
+        void end(const std::string& name);
+
+        /// \brief Read back the spans of the oldest frame in flight, and move on to the next slot of the ring.
+        void next_frame();
+
+        /// \brief Rolling averages of every span which has reported so far, by name.
+        std::map<std::string, Timing> timings() const;
+
+        /// \brief Sum of the rolling GPU times of the spans which ran in the last frame read back,
+        ///        which is the GPU time of a frame so long as spans don't overlap. Spans which have
+        ///        stopped running, like those of a removed camera, don't count.
+        double gpu_total_ms() const;
+
+        /// \brief One line per span, with its CPU and GPU time.
+        std::vector<std::string> report() const;
+
+    private:
+        GpuProfiler() : frame(0), frame_number(0), read_frame(0) {}
+
+        struct Span {
+            unsigned int queries[FRAMES][2];
+            bool pending[FRAMES];
+            size_t begun[FRAMES];
+            std::chrono::steady_clock::time_point cpu_begin;
+        };
+
+    private:
+        unsigned int frame;
+        size_t frame_number;
+        size_t read_frame;
+        std::map<std::string, Span> spans;
+        std::map<std::string, Timing> _timings;
+        mutable std::mutex mutex;
+    };
+}
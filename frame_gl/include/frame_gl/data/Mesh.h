@@ -298,6 +298,12 @@ namespace frame
         inline const VertexAttributeSet& attributes() const { return _attributes; }
         inline bool dynamic_triangles() const { return _dynamic_triangles; }
 
+        ///\brief Get the local space axis aligned bounding box of the first (position) attribute.
+        void bounds(vec3& min, vec3& max) const;
+
+        ///\brief Incremented whenever the vertices or triangles are changed or resized.
+        unsigned int version() const { return _version; }
+
     public:
         void resize(size_t vertex_count, size_t triangle_count);
         void finalize() const;
@@ -332,5 +338,9 @@ namespace frame
         mutable unsigned int vao;
         mutable unsigned int vbo_triangles;
         mutable bool _finalized;
+        mutable bool _bounds_valid;
+        mutable vec3 _bounds_min;
+        mutable vec3 _bounds_max;
+        unsigned int _version;
     };
 }
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "frame_gl/data/Mesh.h"
+#include "frame_gl/parallel.h"
+#include "frame_gl/math.h"
+
+namespace frame
+{
+    /// \class OcclusionBuffer
+    /// \brief Low resolution depth buffer which is rasterized on the CPU from a handful of
+    ///        large occluder meshes, and reduced to a hierarchical depth pyramid against
+    ///        which the bounding boxes of everything else can be tested before drawing.
+    ///
+    /// Depth is stored as window depth in [0, 1], with 0 at the near plane. Occluder triangles
+    /// are binned into square screen tiles, and each tile is rasterized independently, so
+    /// any number of threads may call rasterize() between begin_rasterize() and finish().
+    class OcclusionBuffer {
+    public:
+        OcclusionBuffer(const ivec2& size=ivec2(256, 128), int tile_size=32);
+        OcclusionBuffer(const OcclusionBuffer& other) = delete;
+        OcclusionBuffer& operator=(const OcclusionBuffer& other) = delete;
+
+    public:
+
+        /// \brief Clear the buffer and all binned occluders, and start a new frame with the given camera.
+        void begin(const mat4& view_projection);
+
+        /// \brief Transform the triangles of an occluder mesh to screen space, and bin them into tiles.
+        void add_occluder(const Mesh& mesh, const mat4& model);
+
+        /// \brief Same as above, from positions which are stride bytes apart and don't have to live in a Mesh.
+        void add_occluder(const char* positions, size_t stride, size_t vertex_count, const ivec3* triangles, size_t triangle_count, const mat4& model);
+
+        /// \brief Open the binned tiles up for rasterization, and return the batch generation.
+        unsigned int begin_rasterize();
+
+        /// \brief Rasterize tiles of the given batch until none are left unclaimed.
+        void rasterize(unsigned int generation);
+
+        /// \brief Rasterize any remaining tiles, wait for helpers, and build the depth pyramid.
+        void finish();
+
+        /// \brief Test a local space bounding box against the depth pyramid.
+        /// \return false only if the box is certainly hidden behind occluders or outside the view.
+        bool visible(const vec3& min, const vec3& max, const mat4& model) const;
+
+    public:
+        const ivec2& size() const { return _size; }
+        size_t levels() const { return pyramid.size(); }
+        const ivec2& level_size(size_t level) const { return level_sizes[level]; }
+        float depth(const ivec2& texel, size_t level=0) const { return pyramid[level][texel.y * level_sizes[level].x + texel.x]; }
+        size_t occluder_triangles() const { return triangles.size(); }
+        size_t tile_count() const { return bins.size(); }
+
+    private:
+        struct Triangle {
+            vec3 a, b, c;
+        };
+
+        void rasterize_tile(size_t tile);
+        void build_pyramid();
+
+    private:
+        ivec2 _size;
+        int tile_size;
+        ivec2 tiles;
+        mat4 view_projection;
+        std::vector<Triangle> triangles;
+        std::vector< std::vector<uint32_t> > bins;
+        std::vector< std::vector<float> > pyramid;
+        std::vector<ivec2> level_sizes;
+        WorkQueue work;
+        unsigned int generation;
+    };
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "frame_gl/data/FrameBuffer.h"
+#include "frame_gl/data/FrameBufferPool.h"
+#include "frame_gl/data/Texture.h"
+#include "frame_gl/math.h"
+
+namespace frame
+{
+    /// \class RenderGraph
+    /// \brief Collects the passes of a frame along with the targets they read and write, and runs
+    ///        them all at once at the end of the frame.
+    ///
+    /// Before running anything, the graph
+    ///  - drops passes which only write transient targets that nothing reads afterwards,
+    ///  - orders the rest so that passes on the same target run back to back wherever their
+    ///    dependencies allow, so each run needs only one frame buffer bind,
+    ///  - and works out when each transient target is first and last used, taking it from the
+    ///    pool just before its first pass and giving it back right after its last.
+    ///
+    /// Imported frame buffers, and the screen, are assumed to be read by someone outside of the
+    /// graph, so passes which write them are never dropped.
+    class RenderGraph {
+    public:
+        typedef size_t Handle;
+
+        /// \brief Runs a pass. The pass's target is already bound, with its default state.
+        typedef std::function<void ()> Execute;
+
+    public:
+        RenderGraph();
+        RenderGraph(const RenderGraph& other) = delete;
+        RenderGraph& operator=(const RenderGraph& other) = delete;
+
+    public:
+
+        /// \brief Get the handle of a frame buffer which lives outside of the graph.
+        Handle import(FrameBuffer* buffer);
+
+        /// \brief The window's default frame buffer. Passes on it bind it themselves.
+        Handle screen() const { return 0; }
+
+        /// \brief Declare a target which only lives for this frame, and comes from the pool.
+        Handle create(const ivec2& size, Texture::Format format=Texture::RGBA8, bool depth=false, FrameBuffer::DepthFormat depth_format=FrameBuffer::Depth24);
+
+        /// \brief Declare a pass which draws to target, sampling from each of reads.
+        void add_pass(const std::string& name, Handle target, const std::vector<Handle>& reads, const Execute& execute, bool clear=false);
+
+        /// \brief Cull, order and run every pass declared since the last execute, then start over.
+        void execute(FrameBufferPool& pool);
+
+        /// \brief The names of the passes execute() would run, in the order it would run them.
+        std::vector<std::string> plan() const;
+
+        /// \brief The frame buffer behind a handle. Transient targets only have one while the
+        ///        graph is running, between their first and last passes.
+        FrameBuffer* buffer(Handle handle) const { return resources[handle].buffer; }
+
+        bool empty() const { return passes.empty(); }
+
+        /// \brief Counts from the last execute.
+        size_t passes_run() const { return _passes_run; }
+        size_t passes_culled() const { return _passes_culled; }
+        size_t target_binds() const { return _target_binds; }
+
+    private:
+        struct TargetResource {
+            FrameBuffer* buffer;
+            bool transient;
+            ivec2 size;
+            Texture::Format format;
+            bool depth;
+            FrameBuffer::DepthFormat depth_format;
+            size_t first;
+            size_t last;
+        };
+
+        struct Pass {
+            std::string name;
+            Handle target;
+            std::vector<Handle> reads;
+            Execute execute;
+            bool clear;
+        };
+
+        bool depends(const Pass& later, const Pass& earlier) const;
+        size_t schedule(std::vector<size_t>& order) const;
+        void reset();
+
+    private:
+        std::vector<TargetResource> resources;
+        std::unordered_map<FrameBuffer*, Handle> imported;
+        std::vector<Pass> passes;
+        size_t _passes_run;
+        size_t _passes_culled;
+        size_t _target_binds;
+        bool running;
+    };
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace frame
+{
+    /// \struct RenderCounters
+    /// \brief Tallies of the GL work done over some span of a frame.
+    struct RenderCounters {
+        size_t draw_calls;
+        size_t triangles;
+        size_t vertices;
+        size_t program_binds;
+        size_t texture_binds;
+        size_t vao_binds;
+        size_t fbo_binds;
+        size_t uniform_uploads;
+        size_t uniform_skips;
+        size_t buffer_bytes;
+        size_t objects_culled;
+
+        RenderCounters() { reset(); }
+
+        void reset() {
+            draw_calls = triangles = vertices = 0;
+            program_binds = texture_binds = vao_binds = fbo_binds = 0;
+            uniform_uploads = uniform_skips = buffer_bytes = objects_culled = 0;
+        }
+
+        RenderCounters& operator+=(const RenderCounters& other) {
+            draw_calls += other.draw_calls;
+            triangles += other.triangles;
+            vertices += other.vertices;
+            program_binds += other.program_binds;
+            texture_binds += other.texture_binds;
+            vao_binds += other.vao_binds;
+            fbo_binds += other.fbo_binds;
+            uniform_uploads += other.uniform_uploads;
+            uniform_skips += other.uniform_skips;
+            buffer_bytes += other.buffer_bytes;
+            objects_culled += other.objects_culled;
+            return *this;
+        }
+
+        RenderCounters operator-(const RenderCounters& other) const {
+            RenderCounters result;
+            result.draw_calls = draw_calls - other.draw_calls;
+            result.triangles = triangles - other.triangles;
+            result.vertices = vertices - other.vertices;
+            result.program_binds = program_binds - other.program_binds;
+            result.texture_binds = texture_binds - other.texture_binds;
+            result.vao_binds = vao_binds - other.vao_binds;
+            result.fbo_binds = fbo_binds - other.fbo_binds;
+            result.uniform_uploads = uniform_uploads - other.uniform_uploads;
+            result.uniform_skips = uniform_skips - other.uniform_skips;
+            result.buffer_bytes = buffer_bytes - other.buffer_bytes;
+            result.objects_culled = objects_culled - other.objects_culled;
+            return result;
+        }
+
+        std::string summary() const {
+            return
+                "draws " + std::to_string(draw_calls) +
+                ", tris " + std::to_string(triangles) +
+                ", verts " + std::to_string(vertices) +
+                ", binds (prog " + std::to_string(program_binds) +
+                ", tex " + std::to_string(texture_binds) +
+                ", vao " + std::to_string(vao_binds) +
+                ", fbo " + std::to_string(fbo_binds) +
+                "), uniforms " + std::to_string(uniform_uploads) +
+                " (skipped " + std::to_string(uniform_skips) + ")" +
+                ", bytes " + std::to_string(buffer_bytes) +
+                ", culled " + std::to_string(objects_culled);
+        }
+    };
+
+    /// \struct RenderStats
+    /// \brief The counters of the last frame, in total and split by camera and by layer.
+    ///
+    /// The GL wrappers (Mesh, Shader, Texture, FrameBuffer and the uniform buffers) tally their
+    /// work into live() as it happens, on the GL thread. Render snapshots live() around each
+    /// camera. Layers only get the draws, triangles, vertices and culls of their own renderers,
+    /// since binds and uploads are shared between layers.
+    struct RenderStats {
+        struct CameraStats {
+            unsigned int layer_mask;
+            bool skipped;
+            RenderCounters counters;
+        };
+
+        RenderCounters total;
+        std::vector<CameraStats> cameras;
+        std::vector<RenderCounters> layers;
+
+        /// \brief Counters which the GL wrappers add to as they go.
+        static RenderCounters& live() {
+            static RenderCounters counters;
+            return counters;
+        }
+    };
+}
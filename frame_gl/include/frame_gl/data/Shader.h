@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 #include "frame/Resource.h"
@@ -22,7 +23,9 @@ namespace frame
     };
 
     /// \class ShaderPart
-    /// \brief One part of a full shader program.
+    /// \brief One part of a full shader program. It is compiled the first time its id is
+    ///        needed, so parts of programs which come out of the binary cache never are, and
+    ///        whether that compile worked is only asked once the program using it is needed.
     class ShaderPart {
     public:
         enum Type {
@@ -40,15 +43,37 @@ namespace frame
         ~ShaderPart();
         ShaderPart(const ShaderPart& other) = delete;
         ShaderPart& operator=(const ShaderPart& other) = delete;
-        unsigned int id() { return _id; }
+        unsigned int id() { if (!_compiled) compile(); return _id; }
+        Type type() const { return _type; }
+        const std::vector<std::string>& sources() const { return _sources; }
+
+        /// \brief Wait for the compile, logging any errors. True if it compiled, or never had to.
+        bool check();
+
+    private:
+        void compile();
 
     private:
-        Type type;
+        Type _type;
+        std::vector<std::string> _sources;
         unsigned int _id;
+        bool _compiled;
+        bool _checked;
+        bool _valid;
     };
 
     /// \class Shader
     /// \brief A linked collection of ShaderPass objects
+    ///
+    /// The shader remembers the last value it uploaded to each of its uniforms, and skips
+    /// uploading the same value again. Uniforms should only be set through it for that to hold.
+    ///
+    /// If a cache directory is set, linked programs are saved there with glGetProgramBinary,
+    /// keyed by their sources and the driver, and later runs load them instead of compiling.
+    ///
+    /// Compiling and linking are started when the shader is made, but only waited on the
+    /// first time it is bound or its uniforms are looked up, so the driver can work on many
+    /// programs at once. With KHR_parallel_shader_compile, ready() says whether that would block.
     class Shader {
     public:
         Shader();
@@ -65,8 +90,14 @@ namespace frame
         void unbind() const;
         static void unbind_all();
 
-        const ShaderUniformLocations& uniforms() const { return _uniforms; }
+        /// \brief Whether the program has linked, without waiting for it if the driver can
+        ///        say so. Shaders which failed to build are never ready.
+        bool ready() const;
 
+        const ShaderUniformLocations& uniforms() const { finish(); return _uniforms; }
+
+        /// \brief Upload a uniform by name. Like the other uniform overloads, this expects the
+        ///        shader to be bound already.
         template <typename T>
         void uniform(const char* name, const T& value) const
         { uniform(locate(name), value); }
@@ -80,24 +111,70 @@ namespace frame
         void uniform(ShaderUniform location, const mat4& value) const;
         void uniform(ShaderUniform location, int value) const;
         void uniform_array(int array_location, const mat4* values, int count, int count_location=-1) const;
+
+        /// \brief The location of a uniform, from the table of active uniforms made at link time.
+        ///        Doesn't touch GL, and returns -1 if the shader has no such uniform.
         int locate(const char* name) const;
 
         unsigned int id() { return _id; }
+        const std::string& name() const { return _name; }
+
+        /// \brief The flags this shader was built with, if it came from ShaderVariants, or 0.
+        ///        Shaders of the same family and key are the same shader.
+        unsigned int variant() const { return _variant; }
+
+        /// \brief The parts this shader was linked from.
+        const std::vector< Resource<ShaderPart> >& parts() const { return _parts; }
+
+        /// \brief Returns true if the given part was linked into this shader.
+        bool uses(const Resource<ShaderPart>& part) const;
+
+        /// \brief Where program binaries are kept. The directory has to exist already. Empty
+        ///        turns the cache off, which is the default unless FRAME_SHADER_CACHE is set.
+        static void set_cache_directory(const std::string& directory);
+        static const std::string& cache_directory();
+
+        /// \brief The file name a program linked from the given parts is cached under. The
+        ///        driver strings go into it too, since binaries only load on the driver which made them.
+        static std::string cache_name(const std::vector<std::string>& driver, const std::vector< Resource<ShaderPart> >& parts);
 
     private:
-        void compile();
-        void link();
-        const std::string& name() { return _name; }
+        friend class ShaderVariants;
+
+        void finish() const;
+        void reflect() const;
+        std::string cache_path() const;
+        bool load_binary(const std::string& path);
+        void save_binary(const std::string& path) const;
+        bool changed(int location, const void* value, size_t size) const;
 
     private:
         std::string _name;
         unsigned int _id;
-        ShaderUniformLocations _uniforms;
+        unsigned int _variant;
+
+        enum State { Linking, Linked, Failed };
+        mutable State _state;
+        bool _cached;
+        std::string _cache_path;
+
+        mutable ShaderUniformLocations _uniforms;
+        mutable std::unordered_map<std::string, int> _locations;
+
+        struct UniformValue {
+            size_t size;
+            float data[16];
+        };
+
+        mutable std::vector<UniformValue> _values;
+        std::vector< Resource<ShaderPart> > _parts;
 
     public:
         struct Preset {
             static Resource<ShaderPart> vert_standard();
             static Resource<ShaderPart> vert_skinned();
+            static Resource<ShaderPart> vert_position();
+            static Resource<ShaderPart> vert_indirect();
             static Resource<ShaderPart> frag_uvs();
             static Resource<ShaderPart> frag_diffuse();
             static Resource<ShaderPart> frag_colors();
@@ -105,6 +182,7 @@ namespace frame
             static Resource<ShaderPart> frag_coords();
             static Resource<ShaderPart> frag_depth();
             static Resource<ShaderPart> frag_white();
+            static Resource<ShaderPart> frag_empty();
             static Resource<ShaderPart> frag_solid();
             static Resource<ShaderPart> frag_flat();
             static Resource<Shader> model_uvs();
@@ -113,6 +191,10 @@ namespace frame
             static Resource<Shader> diffuse_texture();
             static Resource<Shader> coords();
             static Resource<Shader> depth();
+            static Resource<Shader> depth_only();
+
+            /// \brief Drawn in place of shaders which aren't ready yet.
+            static Resource<Shader> placeholder();
 
         private:
             Preset() {}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "frame/Resource.h"
+#include "frame_gl/data/Shader.h"
+
+namespace frame
+{
+    /// \class ShaderVariants
+    /// \brief A family of shaders built from the same sources, each with its own set of
+    ///        #define flags switched on.
+    ///
+    /// A variant is named by its key, the bitmask of the flags it defines, and is only compiled
+    /// the first time it's asked for. Each stage is only specialized on the flags its sources
+    /// mention, so variants which differ in fragment flags alone share a single vertex part.
+    class ShaderVariants {
+    public:
+        typedef unsigned int Key;
+
+        struct Stage {
+            ShaderPart::Type type;
+            std::vector<std::string> sources;
+        };
+
+    public:
+        ShaderVariants(const std::string& name, const std::vector<Stage>& stages, const std::vector<std::string>& flags);
+        ShaderVariants(const ShaderVariants& other) = delete;
+        ShaderVariants& operator=(const ShaderVariants& other) = delete;
+
+    public:
+
+        /// \brief The bit of a flag, to be or'ed into a key. Unknown flags give 0.
+        Key flag(const std::string& name) const;
+
+        /// \brief The shader with exactly the flags in key defined, made the first time it's asked for.
+        Resource<Shader> get(Key key);
+
+        const std::string& name() const { return _name; }
+        const std::vector<std::string>& flags() const { return _flags; }
+        size_t variant_count() const { return variants.size(); }
+
+    private:
+        Resource<ShaderPart> part(size_t stage, Key key);
+        std::vector<std::string> specialize(const std::vector<std::string>& sources, Key key) const;
+
+    private:
+        std::string _name;
+        std::vector<Stage> stages;
+        std::vector<Key> stage_masks;
+        std::vector<std::string> _flags;
+        std::map< std::pair<size_t, Key>, Resource<ShaderPart> > parts;
+        std::unordered_map< Key, Resource<Shader> > variants;
+    };
+}
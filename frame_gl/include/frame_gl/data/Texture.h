@@ -6,7 +6,19 @@ namespace frame
 {
     class Texture {
     public:
-        Texture(const ivec2& size=ivec2(1), bool multisample=false);
+        /// \brief Internal formats for textures which are rendered to. Smaller formats cut both
+        ///        memory and the bandwidth of every pass which reads or writes them.
+        enum Format {
+            RGBA8,          ///< 4 bytes per pixel
+            SRGB8_A8,       ///< 4 bytes per pixel, gamma encoded on write and decoded on read
+            RGB10_A2,       ///< 4 bytes per pixel, with 2 bits of alpha
+            R11G11B10F,     ///< 4 bytes per pixel, HDR without alpha
+            RGBA16F,        ///< 8 bytes per pixel
+            RGBA32F         ///< 16 bytes per pixel
+        };
+
+    public:
+        Texture(const ivec2& size=ivec2(1), bool multisample=false, Format format=RGBA32F);
         Texture(const std::string& filename);
         ~Texture();
         Texture(const Texture& other) = delete;
@@ -22,6 +34,8 @@ namespace frame
         unsigned int id() const { return _id; }
         unsigned int target() const { return _target; }
         bool multisample() const { return _multisample; }
+        Format format() const { return _format; }
+        bool srgb() const { return _format == SRGB8_A8; }
         void bind(unsigned int texture_unit) const;
         void unbind() const;
 
@@ -29,6 +43,7 @@ namespace frame
         ivec2 _size;
         unsigned int _id;
         bool _multisample;
+        Format _format;
         unsigned int _target;
 
     public:
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include "frame_gl/math.h"
+
+namespace frame
+{
+    /// \class UniformBuffer
+    /// \brief A block of GPU memory backing a std140 uniform block, shared by every shader
+    ///        which declares that block.
+    class UniformBuffer {
+    public:
+        UniformBuffer(size_t size);
+        ~UniformBuffer();
+        UniformBuffer(const UniformBuffer& other) = delete;
+        UniformBuffer& operator=(const UniformBuffer& other) = delete;
+
+    public:
+        void write(const void* data, size_t size, size_t offset=0);
+        void bind(unsigned int binding) const;
+        size_t size() const { return _size; }
+        unsigned int id() const { return _id; }
+
+    private:
+        size_t _size;
+        unsigned int _id;
+    };
+
+    /// \struct CameraBlock
+    /// \brief CPU side of the std140 "Camera" uniform block which Render writes once per camera.
+    ///
+    /// Shaders pick it up by including CameraBlock::glsl() after their #version line. Every
+    /// member is a mat4 or packed into a single vec4 slot, so the C++ layout matches std140.
+    struct CameraBlock {
+        static const unsigned int Binding = 0;
+        static const char* glsl();
+
+        mat4 view;
+        mat4 projection;
+        mat4 view_projection;
+        mat4 inverse_view;
+        mat4 inverse_projection;
+        vec2 screen_size;
+        float time;
+        float padding;
+    };
+
+    /// \struct ObjectBlock
+    /// \brief CPU side of the std140 "Object" uniform block, holding the constants of a single draw.
+    ///
+    /// Blocks are packed into Render's UniformRing and bound by range for each draw. The meaning
+    /// of params is up to the shader, eg. DebugDraw's text size, character index and code.
+    struct ObjectBlock {
+        static const unsigned int Binding = 1;
+        static const char* glsl();
+
+        mat4 model;
+        vec4 color;
+        vec4 params;
+    };
+}
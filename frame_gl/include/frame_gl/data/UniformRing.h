@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace frame
+{
+    /// \class UniformRing
+    /// \brief A uniform buffer split into one region per frame in flight, into which per-object
+    ///        constants are packed linearly and uploaded in bulk.
+    ///
+    /// Constants are pushed to a CPU staging copy of the current frame's region, and flush()
+    /// uploads everything pushed since the last flush with a single call. Draws then pick out
+    /// their own constants with bind(), so the order of draws needn't match the order of pushes.
+    /// A fence guards each region, so the CPU never overwrites a region the GPU is still reading.
+    class UniformRing {
+    public:
+        UniformRing(size_t frame_size, unsigned int frames=3);
+        ~UniformRing();
+        UniformRing(const UniformRing& other) = delete;
+        UniformRing& operator=(const UniformRing& other) = delete;
+
+    public:
+
+        /// \brief Fence the current region, and move on to the next one once the GPU is done with it.
+        void next_frame();
+
+        /// \brief Copy a block of constants into this frame's region.
+        /// \return the offset of the block, to be passed to bind() after the next flush().
+        size_t push(const void* data, size_t size);
+
+        template <typename T>
+        size_t push(const T& value) { return push(&value, sizeof(T)); }
+
+        /// \brief Upload everything pushed since the last flush.
+        void flush();
+
+        /// \brief Bind a block pushed this frame to a uniform block binding point.
+        void bind(unsigned int binding, size_t offset, size_t size) const;
+
+        size_t frame_size() const { return _frame_size; }
+        size_t used() const { return cursor; }
+
+    private:
+        void allocate();
+
+    private:
+        size_t _frame_size;
+        unsigned int frames;
+        unsigned int frame;
+        size_t alignment;
+        size_t cursor;
+        size_t flushed;
+        bool reallocate;
+        unsigned int buffer;
+        std::vector<char> staging;
+        std::vector<void*> fences;
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "frame/System.h"
+#include "frame_gl/data/GpuProfiler.h"
 #include "frame_gl/data/Shader.h"
 #include "frame_gl/data/Mesh.h"
 #include "frame_gl/gui/GUIRect.h"
@@ -42,7 +43,23 @@ namespace frame
 
         void step() {
             update_gui();
-            render_gui();
+
+            // Take the camera and the transform of each GUI element as they are now
+            Camera* camera = render->display_camera(gui_layer);
+            block = render->camera_block(camera);
+            matrices.clear();
+            for (auto rect : node<GUIRect>())
+                matrices.push_back(rect->matrix());
+
+            // Draw over the GUI camera's target once the render graph runs
+            if (!camera->get<RenderTarget>()->prepare_overlay(!matrices.empty()))
+                return;
+            RenderGraph& graph = render->graph();
+            graph.add_pass("GUI", graph.import(camera->target()->frame_buffer()), {}, [this]() {
+                GpuProfiler::get().begin("GUI");
+                render_gui();
+                GpuProfiler::get().end("GUI");
+            });
         }
 
     public:
@@ -85,14 +102,15 @@ namespace frame
 
         void render_gui() {
 
-            // Get the camera for the gui layer
-            Camera* camera = render->display_camera(gui_layer);
+            // Pack the transform of each GUI element
+            offsets.clear();
+            for (const mat4& matrix : matrices)
+                offsets.push_back(render->push_object(matrix));
+            render->flush_objects();
 
             // Get ready to render stuff
-            camera->bind_target();
+            render->bind_camera(block);
             line_shader->bind();
-            line_shader->uniform(ShaderUniform::View, camera->view_matrix());
-            line_shader->uniform(ShaderUniform::Projection, camera->projection_matrix());
 
             // Set up GL
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -102,16 +120,15 @@ namespace frame
             glLineWidth(2.0f);
 
             // Draw rectangles around each GUI element
-            mat4 transform;
             rect_mesh->bind();
-            for (auto rect : node<GUIRect>()) {
-                line_shader->uniform(ShaderUniform::Model, rect->matrix());
+            for (size_t offset : offsets) {
+                render->bind_object(offset);
                 rect_mesh->render();
             }
             rect_mesh->unbind();
 
             line_shader->unbind();
-            camera->unbind_target();
+            glDisable(GL_BLEND);
         }
 
     private:
@@ -119,6 +136,9 @@ namespace frame
         Window* window;
         Shader* line_shader;
         Mesh* rect_mesh;
+        CameraBlock block;
+        std::vector<mat4> matrices;
+        std::vector<size_t> offsets;
         Entity* focus;
         vec2 mouse_position;
         int gui_layer;
@@ -0,0 +1,164 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace frame
+{
+    /// \class WorkQueue
+    /// \brief Hands out the indices of a batch of work items to any number of threads.
+    ///
+    /// The thread which opens a batch is expected to drain it as well, so a batch always
+    /// completes even if none of the helper tasks it enqueued ever get to run. Helpers
+    /// holding the generation of an older batch simply find nothing left to claim.
+    class WorkQueue {
+    public:
+        WorkQueue() : generation(0), count(0), next(0), done(0) {}
+        WorkQueue(const WorkQueue& other) = delete;
+        WorkQueue& operator=(const WorkQueue& other) = delete;
+
+    public:
+
+        /// \brief Start a new batch of count items, and return its generation.
+        unsigned int open(size_t count) {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->count = count;
+            next = done = 0;
+            return ++generation;
+        }
+
+        /// \brief Claim the next unclaimed item of the given batch.
+        /// \return false if the batch has moved on or has no items left.
+        bool claim(unsigned int generation, size_t& index) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (generation != this->generation || next >= count)
+                return false;
+            index = next++;
+            return true;
+        }
+
+        /// \brief Mark one claimed item as finished.
+        void complete() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (++done == count)
+                finished.notify_all();
+        }
+
+        /// \brief Process items of the batch on the calling thread until none are left to claim.
+        template <typename Work>
+        void drain(unsigned int generation, Work work) {
+            size_t index;
+            while (claim(generation, index)) {
+                work(index);
+                complete();
+            }
+        }
+
+        /// \brief Block until every item of the current batch has been completed.
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [this]() { return done >= count; });
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable finished;
+        unsigned int generation;
+        size_t count;
+        size_t next;
+        size_t done;
+    };
+
+    /// \class RenderThread
+    /// \brief Runs jobs on a thread of their own, lending that thread the GL context while
+    ///        each one runs.
+    ///
+    /// Only one job runs at a time. The context is handed over with the make_current and release
+    /// functions it's given, so the thread which submits a job gives up the context until it
+    /// calls wait(), and mustn't make GL calls in between.
+    class RenderThread {
+    public:
+        typedef std::function<void ()> Job;
+
+    public:
+        RenderThread(const Job& make_current, const Job& release)
+        : make_current(make_current), release(release), has_job(false), pending(false), quit(false), thread(&RenderThread::run, this) {}
+
+        ~RenderThread() {
+            wait();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+            }
+            ready.notify_one();
+            thread.join();
+        }
+
+        RenderThread(const RenderThread& other) = delete;
+        RenderThread& operator=(const RenderThread& other) = delete;
+
+    public:
+
+        /// \brief Wait for the last job, then start this one with the context moved over to the render thread.
+        void submit(const Job& job) {
+            wait();
+            release();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                this->job = job;
+                has_job = true;
+            }
+            pending = true;
+            ready.notify_one();
+        }
+
+        /// \brief Block until the last job is done, and take the context back for the calling thread.
+        void wait() {
+            if (!pending)
+                return;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                finished.wait(lock, [this]() { return !has_job; });
+            }
+            pending = false;
+            make_current();
+        }
+
+        /// \brief Whether a job has been submitted and not yet waited for.
+        bool busy() const { return pending; }
+
+    private:
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                ready.wait(lock, [this]() { return has_job || quit; });
+                if (!has_job)
+                    return;
+
+                Job current = job;
+                lock.unlock();
+                make_current();
+                current();
+                release();
+                lock.lock();
+
+                has_job = false;
+                finished.notify_all();
+            }
+        }
+
+    private:
+        Job make_current;
+        Job release;
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::condition_variable finished;
+        Job job;
+        bool has_job;
+        bool pending;
+        bool quit;
+        std::thread thread;
+    };
+}
@@ -3,13 +3,16 @@
 #include <tuple>
 #include <utility>
 #include <queue>
+#include <vector>
 #include <utility>
 #include <unordered_map>
 #include "frame/System.h"
 #include "frame_gl/systems/Render.h"
 #include "frame_gl/components/Camera.h"
+#include "frame_gl/data/GpuProfiler.h"
 #include "frame_gl/data/Mesh.h"
 #include "frame_gl/data/Shader.h"
+#include "frame_gl/data/UniformBuffer.h"
 #include "frame_gl/math.h"
 #include "glm/gtc/matrix_transform.hpp"
 using namespace frame;
@@ -79,6 +82,24 @@ namespace frame_gl
             float line_thickness;
         };
 
+        /// \brief Everything waiting to be drawn. Calls fill one set while the render graph
+        ///        draws the other, so the two never touch the same queues.
+        struct Queues {
+            std::queue< Line > lines;
+            std::queue< Arrow > arrows;
+            std::queue< Shape > shapes;
+            std::queue< Shape > screen_shapes;
+            std::queue< DebugMesh > meshes;
+            std::queue< glm::mat4 > cubes;
+            std::queue< String > world_strings;
+            std::queue< String > screen_strings;
+            std::queue< Circle > circles;
+            //std::queue< Arc > arcs;
+        };
+
+        /// \brief A shape's fill and line colors, and the mesh built for it.
+        typedef std::tuple< vec4, vec4, Resource< Mesh > > ShapeMesh;
+
     public:
         enum Alignment { TopLeft, TopRight, BottomLeft, BottomRight };
 
@@ -94,30 +115,30 @@ namespace frame_gl
         }
 
         void line(const glm::vec3& p0, const glm::vec3& p1, const glm::vec4& color = glm::vec4(1.0f), float thickness = 1.0f) {
-            lines.push(Line(p0, p1, color, thickness));
+            queued.lines.push(Line(p0, p1, color, thickness));
         }
 
         void arrow(const glm::vec3& base, const glm::vec3& tip, float size=0.1f, const glm::vec4& color=vec4(1.0f), float thickness=1.0f) {
-            arrows.push(Arrow(base, tip, size, color, thickness));
+            queued.arrows.push(Arrow(base, tip, size, color, thickness));
             line(base, tip, color, thickness);
         }
 
         void shape(const std::vector<glm::vec3>& vertices, const glm::vec4& line_color=vec4(1.0f), const glm::vec4& fill_color=vec4(vec3(0.5f), 1.0f)) {
-            shapes.push(Shape(vertices, line_color, fill_color));
+            queued.shapes.push(Shape(vertices, line_color, fill_color));
         }
 
         void screen_shape(const std::vector<glm::vec3>& vertices, const glm::vec4& line_color=vec4(1.0f), const glm::vec4& fill_color=vec4(vec3(0.5f), 1.0f)) {
-            screen_shapes.push(Shape(vertices, line_color, fill_color));
+            queued.screen_shapes.push(Shape(vertices, line_color, fill_color));
         }
 
         void mesh(Resource<Mesh> mesh, const glm::mat4& transform, const glm::vec4& line_color=vec4(1.0f), const glm::vec4& fill_color=vec4(vec3(0.5f), 1.0f), float line_thickness=1.0f) {
-            meshes.push(DebugMesh(mesh, transform, line_color, fill_color, line_thickness));
+            queued.meshes.push(DebugMesh(mesh, transform, line_color, fill_color, line_thickness));
         }
 
         void circle(const glm::vec3& position, float inner_radius=5.0f, float outer_radius=10.0f, const glm::vec4& color=glm::vec4(1.0f)) {
             if (outer_radius < inner_radius)
                 outer_radius = inner_radius;
-            circles.push(Circle(position, inner_radius, outer_radius, color));
+            queued.circles.push(Circle(position, inner_radius, outer_radius, color));
         }
 
         /*
@@ -133,7 +154,7 @@ namespace frame_gl
         }
 
         void cube(const glm::mat4& transform) {
-            cubes.push(transform);
+            queued.cubes.push(transform);
         }
 
         void world_text(const glm::vec3& position, const std::string& text, const glm::vec3& color, float size = 12.0f, float thickness=1.0f) {
@@ -141,7 +162,7 @@ namespace frame_gl
         }
 
         void world_text(const glm::vec3& position, const std::string& text, const glm::vec4& color=glm::vec4(1.0f), float size=12.0f, float thickness=1.0f) {
-            world_strings.push(String(position, text, color, size, thickness));
+            queued.world_strings.push(String(position, text, color, size, thickness));
         }
 
         void screen_text(const glm::vec2& position, const std::string& text, const glm::vec4& color=glm::vec4(1.0f), float size=12.0f, float thickness=1.0f) {
@@ -171,7 +192,7 @@ namespace frame_gl
             else
                 position.y += size;
 
-            screen_strings.push(String(glm::vec3(position.x, position.y, 0.0f), text, color, size, thickness));
+            queued.screen_strings.push(String(glm::vec3(position.x, position.y, 0.0f), text, color, size, thickness));
         }
 
     protected:
@@ -237,6 +258,11 @@ namespace frame_gl
             }
 
             circle_mesh = new Mesh(DEFAULT_VERTEX_ATTRIBUTES_SIMPLE_DYNAMIC, 0, 0, true);
+            circle_count = 0;
+
+            point_mesh = new Mesh(1, 1);
+            point_mesh->set_vertices({ vec3(0.0f) });
+            point_mesh->set_triangles({ ivec3(0, 0, 0) });
 
             arrowhead_mesh = new Mesh(DEFAULT_VERTEX_ATTRIBUTES_SIMPLE, 5, 2, false);
             {
@@ -267,37 +293,36 @@ namespace frame_gl
                 Shader::Preset::vert_standard(),
                 Shader::Preset::frag_solid());
 
-            auto arc_shader_vert = Resource<ShaderPart>(ShaderPart::Type::Vertex,
+            auto arc_shader_vert = Resource<ShaderPart>(ShaderPart::Type::Vertex, std::vector<std::string>({
                 "#version 330\n                                                 "
                 "layout(location = 0)in vec3 vert_position;                     "
                 "layout(location = 1)in vec3 vert_normal;                       "
                 "layout(location = 2)in vec2 vert_uv;                           "
-                "layout(location = 3)in vec4 vert_color;                        "
-                "uniform mat4 model;                                            "
-                "uniform mat4 view;                                             "
-                "uniform mat4 projection;                                       "
+                "layout(location = 3)in vec4 vert_color;                        ",
+                CameraBlock::glsl(),
+                ObjectBlock::glsl(),
                 "out vec4 geom_position;                                        "
                 "out vec2 geom_angles;                                          "
                 "out vec2 geom_radii;                                           "
                 "out vec4 geom_color;                                           "
                 "void main() {                                                  "
-                "   mat4 transform  = projection * view * model;                "
+                "   mat4 transform  = view_projection * model;                  "
                 "   geom_position   = transform * vec4(vert_position, 1.0);     "
                 "   geom_angles     = vert_normal.xy;                           "
                 "   geom_radii      = vert_uv;                                  "
                 "   geom_color      = vert_color;                               "
                 "   gl_Position     = geom_position;                            "
-                "}                                                              ");
+                "}                                                              "}));
 
             circle_shader = Resource<Shader>(
                 "Debug Circle Shader",
                 arc_shader_vert,
-                Resource<ShaderPart>(ShaderPart::Type::Geometry,
+                Resource<ShaderPart>(ShaderPart::Type::Geometry, std::vector<std::string>({
                     "#version 330\n"
                     "#define pi 3.1415926535897932384626433832795\n"
                     "layout(triangles) in;"
-                    "layout(triangle_strip, max_vertices = 128) out;"
-                    "uniform vec2 screen_size;"
+                    "layout(triangle_strip, max_vertices = 128) out;",
+                    CameraBlock::glsl(),
                     "in vec4 geom_position[3];"
                     "in vec2 geom_radii[3];"
                     "in vec4 geom_color[3];"
@@ -319,7 +344,7 @@ namespace frame_gl
                     "       EmitVertex();                                           "
                     "   }                                                           "
                     "}"
-                    ),
+                    })),
 
                 Resource<ShaderPart>(ShaderPart::Type::Fragment,
                     "#version 330\n"
@@ -333,12 +358,12 @@ namespace frame_gl
             arc_shader = Resource<Shader>(
                 "Debug Arc Shader",
                 arc_shader_vert,
-                Resource<ShaderPart>(ShaderPart::Type::Geometry,
+                Resource<ShaderPart>(ShaderPart::Type::Geometry, std::vector<std::string>({
                     "#version 330\n                                                                 "
                     "#define pi 3.1415926535897932384626433832795\n                                 "
                     "layout(lines) in;                                                              "
-                    "layout(triangle_strip, max_vertices = 128) out;                                "
-                    "uniform vec2 screen_size;                                                      "
+                    "layout(triangle_strip, max_vertices = 128) out;                                ",
+                    CameraBlock::glsl(),
                     "in vec4 geom_position[2];                                                      "
                     "in vec2 geom_angles[2];                                                        "
                     "in vec2 geom_radii[2];                                                         "
@@ -364,7 +389,7 @@ namespace frame_gl
                     "       EmitVertex();                                                           "
                     "   }                                                                           "
                     "}"
-                    ),
+                    })),
 
                 Resource<ShaderPart>(ShaderPart::Type::Fragment,
                     "#version 330\n"
@@ -378,30 +403,30 @@ namespace frame_gl
             text_shader = Resource<Shader>(
                 "Debug Text Shader",
 
-                Resource<ShaderPart>(ShaderPart::Type::Vertex,
+                Resource<ShaderPart>(ShaderPart::Type::Vertex, std::vector<std::string>({
                     "#version 330\n                                                 "
-                    "layout(location = 0)in vec3 vert_position;                     "
-                    "uniform mat4 model;                                            "
-                    "uniform mat4 view;                                             "
-                    "uniform mat4 projection;                                       "
+                    "layout(location = 0)in vec3 vert_position;                     ",
+                    CameraBlock::glsl(),
+                    ObjectBlock::glsl(),
                     "out vec4 geom_position;                                        "
                     "void main() {                                                  "
-                    "    mat4 transform = projection * view * model;                "
+                    "    mat4 transform = view_projection * model;                  "
                     "    geom_position  = transform * vec4(vert_position, 1.0);     "
                     "    gl_Position    = geom_position;                            "
                     "}                                                              "
-                ),
+                })),
 
-                Resource<ShaderPart>(ShaderPart::Type::Geometry,
+                Resource<ShaderPart>(ShaderPart::Type::Geometry, std::vector<std::string>({
                     "#version 330\n"
                     "layout(triangles) in;"
-                    "layout(line_strip, max_vertices = 16) out;"
-                    "uniform float character_size;"
-                    "uniform int character_number;"
-                    "uniform int character_code;"
-                    "uniform vec2 screen_size;"
+                    "layout(line_strip, max_vertices = 16) out;",
+                    CameraBlock::glsl(),
+                    ObjectBlock::glsl(),
                     "in vec4 geom_position[3];"
                     "void main() {"
+                    "   float character_size = object_params.x;"
+                    "   int character_number = int(object_params.y);"
+                    "   int character_code = int(object_params.z);"
                     "   vec4 scale = vec4(1.0f / screen_size.x, 1.0f / screen_size.y, 0, 0) * (geom_position[0].w * character_size);"
                     "   vec4 pos = vec4((character_number) * scale.x, 0, 0, 0) + geom_position[0];"
 
@@ -844,16 +869,16 @@ namespace frame_gl
 
                     "   EndPrimitive();"
                     "}"
-                ),
+                })),
 
-                Resource<ShaderPart>(ShaderPart::Type::Fragment,
-                    "#version 330\n"
-                    "uniform vec4 character_color;"
+                Resource<ShaderPart>(ShaderPart::Type::Fragment, std::vector<std::string>({
+                    "#version 330\n",
+                    ObjectBlock::glsl(),
                     "out vec4 pixel_color;"
                     "void main() {"
-                    "    pixel_color = character_color;"
+                    "    pixel_color = object_color;"
                     "}"
-                )
+                }))
             );
         }
 
@@ -862,6 +887,7 @@ namespace frame_gl
             delete cube_mesh;
             delete circle_mesh;
             delete arrowhead_mesh;
+            delete point_mesh;
         }
 
         void step() {
@@ -870,56 +896,110 @@ namespace frame_gl
             main_camera = render->display_camera(main_layer);
             gui_camera = render->display_camera(gui_layer);
 
-            // Get the main display camera
-            if (main_camera) {
-
-                // Bind the render target
-                main_camera->bind_target();
+            // Hand everything queued so far to the passes, and start queueing the next frame.
+            // Anything a skipped pass never drew is dropped.
+            drawing = Queues();
+            std::swap(queued, drawing);
+
+            // Draw on top of whatever the cameras render, once the render graph runs. The passes
+            // get a copy of each camera, which may have moved on by the time they run.
+            RenderGraph& graph = render->graph();
+            bool world_content =
+                !drawing.lines.empty() || !drawing.arrows.empty() || !drawing.shapes.empty() || !drawing.meshes.empty() ||
+                !drawing.cubes.empty() || !drawing.circles.empty() || !drawing.world_strings.empty();
+            bool screen_content = !drawing.screen_strings.empty() || !drawing.screen_shapes.empty();
+
+            // Meshes are built here, since the passes run on the render thread and should only draw
+            build_shapes(drawing.shapes, shape_meshes);
+            build_shapes(drawing.screen_shapes, screen_shape_meshes);
+            build_circles();
+            if (main_camera && main_camera->get<RenderTarget>()->prepare_overlay(world_content)) {
+                CameraBlock camera = render->camera_block(main_camera);
+                graph.add_pass("DebugDraw", graph.import(main_camera->target()->frame_buffer()), {}, [this, camera]() { render_main(camera); });
+            }
+            if (gui_camera && gui_camera->get<RenderTarget>()->prepare_overlay(screen_content)) {
+                CameraBlock camera = render->camera_block(gui_camera);
+                graph.add_pass("DebugDraw screen", graph.import(gui_camera->target()->frame_buffer()), {}, [this, camera]() { render_gui(camera); });
+            }
+        }
 
-                // Draw worldspace stuff
-                render_lines(main_camera);
-                render_arrows(main_camera);
-                render_shapes(main_camera, shapes);
-                render_meshes(main_camera);
-                render_cubes(main_camera);
-                render_circles(main_camera);
-                render_text(main_camera, world_strings);
+    private:
 
-                // Tear down
-                main_camera->unbind_target();
-            }
+        void render_main(const CameraBlock& camera) {
 
-            // Get the GUI display camera
-            if (gui_camera) {
+            // Bind the camera as it was when the pass was declared
+            render->bind_camera(camera);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-                // Bind the render target
-                gui_camera->bind_target();
+            // Draw worldspace stuff
+            GpuProfiler& profiler = GpuProfiler::get();
+            profiler.begin("DebugDraw lines");
+            render_lines(camera);
+            profiler.end("DebugDraw lines");
+            profiler.begin("DebugDraw arrows");
+            render_arrows(camera);
+            profiler.end("DebugDraw arrows");
+            profiler.begin("DebugDraw shapes");
+            render_shapes(camera, shape_meshes);
+            profiler.end("DebugDraw shapes");
+            profiler.begin("DebugDraw meshes");
+            render_meshes(camera);
+            profiler.end("DebugDraw meshes");
+            profiler.begin("DebugDraw cubes");
+            render_cubes(camera);
+            profiler.end("DebugDraw cubes");
+            profiler.begin("DebugDraw circles");
+            render_circles(camera);
+            profiler.end("DebugDraw circles");
+            profiler.begin("DebugDraw text");
+            render_text(camera, drawing.world_strings);
+            profiler.end("DebugDraw text");
+
+            // Tear down
+            glDisable(GL_BLEND);
+        }
 
-                // Draw gui (screen) space stuff
-                render_text(gui_camera, screen_strings);
+        void render_gui(const CameraBlock& camera) {
 
-                render_shapes(gui_camera, screen_shapes);
+            // Bind the camera as it was when the pass was declared
+            render->bind_camera(camera);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-                // Tear down
-                gui_camera->unbind_target();
-            }
+            // Draw gui (screen) space stuff
+            GpuProfiler& profiler = GpuProfiler::get();
+            profiler.begin("DebugDraw screen text");
+            render_text(camera, drawing.screen_strings);
+            profiler.end("DebugDraw screen text");
+            profiler.begin("DebugDraw screen shapes");
+            render_shapes(camera, screen_shape_meshes);
+            profiler.end("DebugDraw screen shapes");
+
+            // Tear down
+            glDisable(GL_BLEND);
         }
 
-    private:
-
-        void render_lines(Camera* camera) {
+        void render_lines(const CameraBlock& camera) {
 
-            if (lines.empty())
+            if (drawing.lines.empty())
                 return;
 
+            // Pack the constants of every line
+            offsets.clear();
+            thicknesses.clear();
+            while (!drawing.lines.empty()) {
+                auto& line = drawing.lines.front();
+                vec3 ab = line.b - line.a;
+                mat4 transform = glm::translate(mat4(1.0f), line.a) * glm::scale(quat(vec3(1.0f, 0.0f, 0.0f), ab).matrix(), vec3(length(ab)));
+                offsets.push_back(render->push_object(transform, line.color));
+                thicknesses.push_back(line.thickness);
+                drawing.lines.pop();
+            }
+            render->flush_objects();
+
             // Bind the shape shader
             shape_shader->bind();
-            shape_shader->uniform(ShaderUniform::View, camera->view_matrix());
-            shape_shader->uniform(ShaderUniform::Projection, camera->projection_matrix());
-            int color = shape_shader->locate("color");
-
-            // Just need one model matrix
-            //line_shader->uniform(ShaderUniform::Model, glm::mat4(1.0f));
 
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
             glDisable(GL_CULL_FACE);
@@ -928,36 +1008,37 @@ namespace frame_gl
 
             line_mesh->bind();
 
-            while (!lines.empty()) {
-                auto& line = lines.front();
-
-                glLineWidth(line.thickness);
-
-                vec3 ab = line.b - line.a;
-                mat4 transform = glm::translate(mat4(1.0f), line.a) * glm::scale(quat(vec3(1.0f, 0.0f, 0.0f), ab).matrix(), vec3(length(ab)));
-                shape_shader->uniform(ShaderUniform::Model, transform);
-                shape_shader->uniform(color, line.color);
-
+            for (size_t i = 0; i < offsets.size(); ++i) {
+                glLineWidth(thicknesses[i]);
+                render->bind_object(offsets[i]);
                 line_mesh->render();
-                lines.pop();
-            };
+            }
 
             line_mesh->unbind();
             shape_shader->unbind();
         }
 
-        void render_arrows(Camera* camera) {
+        void render_arrows(const CameraBlock& camera) {
 
-            if (arrows.empty())
+            if (drawing.arrows.empty())
                 return;
 
+            // Pack the constants of every arrowhead
+            offsets.clear();
+            thicknesses.clear();
+            while (!drawing.arrows.empty()) {
+                auto& arrow = drawing.arrows.front();
+                mat4 rotate = quat(vec3(1.0f, 0.0f, 0.0f), arrow.tip - arrow.base).matrix();
+                mat4 translate = glm::translate(mat4(1.0f), arrow.tip);
+                mat4 scale = glm::scale(mat4(1.0f), vec3(arrow.size));
+                offsets.push_back(render->push_object(translate * rotate * scale, arrow.color));
+                thicknesses.push_back(arrow.thickness);
+                drawing.arrows.pop();
+            }
+            render->flush_objects();
+
             // Bind the shape shader
             shape_shader->bind();
-            shape_shader->uniform(ShaderUniform::View, camera->view_matrix());
-            shape_shader->uniform(ShaderUniform::Projection, camera->projection_matrix());
-
-            // Find the color uniform location
-            int color = shape_shader->locate("color");
 
             // Set up gl state
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -967,37 +1048,20 @@ namespace frame_gl
 
             // Draw all the arrowheads
             arrowhead_mesh->bind();
-            while (!arrows.empty()) {
-                auto& arrow = arrows.front();
-                glLineWidth(float(arrow.thickness));
-                mat4 rotate = quat(vec3(1.0f, 0.0f, 0.0f), arrow.tip - arrow.base).matrix();
-                mat4 translate = glm::translate(mat4(1.0f), arrow.tip);
-                mat4 scale = glm::scale(mat4(1.0f), vec3(arrow.size));
-                shape_shader->uniform(ShaderUniform::Model, translate * rotate * scale);
-                shape_shader->uniform(color, arrow.color);
+            for (size_t i = 0; i < offsets.size(); ++i) {
+                glLineWidth(thicknesses[i]);
+                render->bind_object(offsets[i]);
                 arrowhead_mesh->draw();
-                arrows.pop();
             }
             arrowhead_mesh->unbind();
 
             shape_shader->unbind();
         }
 
-        void render_shapes(Camera* camera, std::queue< Shape >& shapes_queue) {
-
-            if (shapes_queue.empty())
-                return;
-
-            // Bind the shape shader
-            shape_shader->bind();
-            shape_shader->uniform(ShaderUniform::View, camera->view_matrix());
-            shape_shader->uniform(ShaderUniform::Projection, camera->projection_matrix());
-
-            // Just need one model matrix
-            shape_shader->uniform(ShaderUniform::Model, glm::mat4(1.0f));
+        void build_shapes(std::queue< Shape >& shapes_queue, std::vector< ShapeMesh >& meshes) {
 
-            // Build a mesh with a bunch of lines
-            std::vector< std::tuple< vec4, vec4, Resource< Mesh > > > meshes;
+            // Build a mesh for each shape, along with its fill and line colors
+            meshes.clear();
             while (!shapes_queue.empty()) {
                 Shape& shape = shapes_queue.front();
                 Resource< Mesh > mesh(DEFAULT_VERTEX_ATTRIBUTES_SIMPLE, shape.vertices.size(), shape.vertices.size() - 2);
@@ -1009,59 +1073,96 @@ namespace frame_gl
                 meshes.push_back(std::make_tuple(shape.fill_color, shape.line_color, mesh));
                 shapes_queue.pop();
             }
+        }
+
+        void build_circles() {
+
+            // Every circle is a single point, which the circle shader grows into a disc
+            circle_count = drawing.circles.size();
+            if (circle_count == 0)
+                return;
+            circle_mesh->resize(circle_count, circle_count);
+            int index = 0;
+            while (!drawing.circles.empty()) {
+                auto& circle = drawing.circles.front();
+                circle_mesh->set_vertex(index, circle.position, vec3(1.0f, 0.0f, 0.0f), vec2(circle.radii.min, circle.radii.max), circle.color);
+                circle_mesh->set_triangle(index, ivec3(index));
+                ++index;
+                drawing.circles.pop();
+            }
+        }
+
+        void render_shapes(const CameraBlock& camera, const std::vector< ShapeMesh >& meshes) {
+
+            if (meshes.empty())
+                return;
+
+            // Pack the fill and line colors of each shape
+            offsets.clear();
+            for (auto& mesh : meshes) {
+                offsets.push_back(render->push_object(glm::mat4(1.0f), std::get<0>(mesh)));
+                offsets.push_back(render->push_object(glm::mat4(1.0f), std::get<1>(mesh)));
+            }
+            render->flush_objects();
+
+            // Bind the shape shader
+            shape_shader->bind();
 
             glDisable(GL_CULL_FACE);
             glEnable(GL_BLEND);
             glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-            int color = shape_shader->locate("color");
-
             // Draw shape fills
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            for (auto& mesh : meshes) {
-                if (std::get<0>(mesh).a == 0.0f) continue;
-                shape_shader->uniform(color, std::get<0>(mesh));
-                std::get<2>(mesh)->render();
+            for (size_t i = 0; i < meshes.size(); ++i) {
+                if (std::get<0>(meshes[i]).a == 0.0f) continue;
+                render->bind_object(offsets[2 * i]);
+                std::get<2>(meshes[i])->render();
             }
 
             // Draw shape lines
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
             glLineWidth(2.0f);
-            for (auto& mesh : meshes) {
-                if (std::get<1>(mesh).a == 0.0f) continue;
-                shape_shader->uniform(color, std::get<1>(mesh));
-                std::get<2>(mesh)->render();
+            for (size_t i = 0; i < meshes.size(); ++i) {
+                if (std::get<1>(meshes[i]).a == 0.0f) continue;
+                render->bind_object(offsets[2 * i + 1]);
+                std::get<2>(meshes[i])->render();
             }
 
             shape_shader->unbind();
         }
 
-        void render_meshes(Camera* camera) {
+        void render_meshes(const CameraBlock& camera) {
 
-            if (meshes.empty())
+            if (drawing.meshes.empty())
                 return;
 
+            // Pack the fill and line constants of every mesh
+            std::vector< DebugMesh > drawn;
+            offsets.clear();
+            while (!drawing.meshes.empty()) {
+                DebugMesh& mesh = drawing.meshes.front();
+                offsets.push_back(render->push_object(mesh.transform, mesh.fill_color));
+                offsets.push_back(render->push_object(mesh.transform, mesh.line_color));
+                drawn.push_back(mesh);
+                drawing.meshes.pop();
+            }
+            render->flush_objects();
+
             // Bind the shape shader
             shape_shader->bind();
-            shape_shader->uniform(ShaderUniform::View, camera->view_matrix());
-            shape_shader->uniform(ShaderUniform::Projection, camera->projection_matrix());
-
-            int color = shape_shader->locate("color");
 
             glDisable(GL_CULL_FACE);
             glEnable(GL_BLEND);
             glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-            // Build a mesh with a bunch of lines
-            while (!meshes.empty()) {
-                DebugMesh& mesh = meshes.front();
-
-                shape_shader->uniform(ShaderUniform::Model, mesh.transform);
+            for (size_t i = 0; i < drawn.size(); ++i) {
+                DebugMesh& mesh = drawn[i];
 
                 // Draw shape fills
                 glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
                 if (mesh.fill_color.a > std::numeric_limits<float>::epsilon()) {
-                    shape_shader->uniform(color, mesh.fill_color);
+                    render->bind_object(offsets[2 * i]);
                     mesh.mesh->render();
                 }
 
@@ -1069,109 +1170,92 @@ namespace frame_gl
                 glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
                 glLineWidth(mesh.line_thickness);
                 if (mesh.line_color.a > std::numeric_limits<float>::epsilon()) {
-                    shape_shader->uniform(color, mesh.line_color);
+                    render->bind_object(offsets[2 * i + 1]);
                     mesh.mesh->render();
                 }
-
-                meshes.pop();
             }
 
             shape_shader->unbind();
         }
 
-        void render_cubes(Camera* camera) {
+        void render_cubes(const CameraBlock& camera) {
 
-            if (cubes.empty())
+            if (drawing.cubes.empty())
                 return;
 
+            // Pack the transform of every cube
+            offsets.clear();
+            while (!drawing.cubes.empty()) {
+                offsets.push_back(render->push_object(drawing.cubes.front()));
+                drawing.cubes.pop();
+            }
+            render->flush_objects();
+
             // Bind the shape shader
             cube_shader->bind();
-            cube_shader->uniform(ShaderUniform::View, camera->view_matrix());
-            cube_shader->uniform(ShaderUniform::Projection, camera->projection_matrix());
 
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
             glEnable(GL_CULL_FACE);
 
-            while (!cubes.empty()) {
-                cube_shader->uniform(ShaderUniform::Model, cubes.front());
+            for (size_t offset : offsets) {
+                render->bind_object(offset);
                 cube_mesh->render();
-                cubes.pop();
             }
 
             cube_shader->unbind();
         }
 
-        void render_circles(Camera* camera) {
+        void render_circles(const CameraBlock& camera) {
 
-            if (circles.empty())
+            if (circle_count == 0)
                 return;
 
+            render->bind_object(render->push_object(glm::mat4(1.0f)));
+            render->flush_objects();
+
             circle_shader->bind();
-            circle_shader->uniform(ShaderUniform::View, camera->view_matrix());
-            circle_shader->uniform(ShaderUniform::Projection, camera->projection_matrix());
-            circle_shader->uniform(ShaderUniform::Model, glm::mat4(1.0f));
-            circle_shader->uniform("screen_size", camera->target()->size());
 
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
             glDisable(GL_CULL_FACE);
             glDisable(GL_DEPTH_TEST);
 
-            circle_mesh->resize(circles.size(), circles.size());
-            int index = 0;
-            while (!circles.empty()) {
-                auto& circle = circles.front();
-                circle_mesh->set_vertex(index, circle.position, vec3(1.0f, 0.0f, 0.0f), vec2(circle.radii.min, circle.radii.max), circle.color);
-                circle_mesh->set_triangle(index, ivec3(index));
-                ++index;
-                circles.pop();
-            }
-
             circle_mesh->render();
             circle_shader->unbind();
         }
 
-        void render_text(Camera* camera, std::queue< String >& strings) {
+        void render_text(const CameraBlock& camera, std::queue< String >& strings) {
 
             if (strings.empty() && strings.empty())
                 return;
 
-            // Find the uniforms we'll be tweaking
-            int character_color = text_shader->locate("character_color");
-            int character_number = text_shader->locate("character_number");
-            int character_code = text_shader->locate("character_code");
-            int character_size = text_shader->locate("character_size");
-
-            text_shader->uniform("screen_size", camera->target()->size());
+            // Pack the constants of every character. The params are the
+            // character size, its index in the string and its code.
+            offsets.clear();
+            thicknesses.clear();
+            while (!strings.empty()) {
+                const String& line = strings.front();
+                mat4 transform = glm::translate(glm::mat4(1.0f), line.position);
+                int i = 0;
+                for (char c : line.text) {
+                    offsets.push_back(render->push_object(transform, line.color, vec4(line.size, float(i++), float(c), 0.0f)));
+                    thicknesses.push_back(line.thickness);
+                }
+                strings.pop();
+            }
+            render->flush_objects();
 
             // Bind the text shader
             text_shader->bind();
 
-            Mesh mesh(1, 1);
-            mesh.set_vertices({ vec3(0.0f) });
-            mesh.set_triangles({ ivec3(0, 0, 0) });
-
             glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
             glDisable(GL_CULL_FACE);
             glDisable(GL_DEPTH_TEST);
 
-            // Draw each string
-            text_shader->uniform(ShaderUniform::View, camera->view_matrix());
-            text_shader->uniform(ShaderUniform::Projection, camera->projection_matrix());
-
-            while (!strings.empty()) {
-                const String& line = strings.front();
-                text_shader->uniform(ShaderUniform::Model, glm::translate(glm::mat4(1.0f), line.position));
-                text_shader->uniform(character_size, line.size);
-                text_shader->uniform(character_color, line.color);
-
-                glLineWidth(line.thickness);
-                int i = 0;
-                for (char c : line.text) {
-                    text_shader->uniform(character_number, i++);
-                    text_shader->uniform(character_code, (int)c);
-                    mesh.render();
-                }
-                strings.pop();
+            // Draw each character
+            for (size_t i = 0; i < offsets.size(); ++i) {
+                glLineWidth(thicknesses[i]);
+                render->bind_object(offsets[i]);
+                point_mesh->render();
             }
 
             text_shader->unbind();
@@ -1192,18 +1276,16 @@ namespace frame_gl
         Mesh* cube_mesh;
         Mesh* circle_mesh;
         Mesh* arrowhead_mesh;
+        Mesh* point_mesh;
+        size_t circle_count;
+        std::vector< ShapeMesh > shape_meshes;
+        std::vector< ShapeMesh > screen_shape_meshes;
 
         int text_shader_characters;
-        std::queue< Line > lines;
-        std::queue< Arrow > arrows;
-        std::queue< Shape > shapes;
-        std::queue< Shape > screen_shapes;
-        std::queue< DebugMesh > meshes;
-        std::queue< glm::mat4 > cubes;
-        std::queue< String > world_strings;
-        std::queue< String > screen_strings;
-        std::queue< Circle > circles;
-        //std::queue< Arc > arcs;
+        std::vector< size_t > offsets;
+        std::vector< float > thicknesses;
+        Queues queued;
+        Queues drawing;
 
         std::atomic<bool> loaded;
 
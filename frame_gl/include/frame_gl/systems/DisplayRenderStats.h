@@ -0,0 +1,51 @@
+#pragma once
+#include "frame/System.h"
+#include "frame_gl/data/GpuProfiler.h"
+#include "frame_gl/systems/DebugDraw.h"
+#include "frame_gl/systems/Render.h"
+#include "frame_gl/math.h"
+using namespace frame_gl;
+
+namespace frame
+{
+    /// \class DisplayRenderStats
+    /// \brief Draws the counters of the last rendered frame, and the timings of each pass, in the
+    ///        top left corner of the screen.
+    FRAME_SYSTEM(DisplayRenderStats) {
+    public:
+        DisplayRenderStats() : debug_draw(nullptr), render(nullptr) {}
+
+    public:
+
+        void setup() {
+            debug_draw = frame()->systems().get<frame_gl::DebugDraw>();
+            render = frame()->systems().get<Render>();
+        }
+
+        void step() {
+            if (!debug_draw || !render)
+                return;
+
+            debug_draw->screen_text(DebugDraw::Alignment::TopLeft, glm::vec2(5.0f, 0.0f), render->stats().total.summary());
+
+            // One line per camera beneath the total
+            const auto& cameras = render->stats().cameras;
+            for (size_t i = 0; i < cameras.size(); ++i) {
+                std::string line = "Camera " + std::to_string(i) + ": " +
+                    (cameras[i].skipped ? std::string("skipped, unchanged") : cameras[i].counters.summary());
+                debug_draw->screen_text(DebugDraw::Alignment::TopLeft, glm::vec2(5.0f, 14.0f * (i + 1)), line);
+            }
+
+            // Followed by the timings of each pass
+            float y = 14.0f * (cameras.size() + 1);
+            for (auto& line : GpuProfiler::get().report()) {
+                debug_draw->screen_text(DebugDraw::Alignment::TopLeft, glm::vec2(5.0f, y), line);
+                y += 14.0f;
+            }
+        }
+
+    private:
+        frame_gl::DebugDraw* debug_draw;
+        Render* render;
+    };
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include "frame/System.h"
+#include "frame/Node.h"
+#include "frame_gl/components/RenderTarget.h"
+#include "frame_gl/data/GpuProfiler.h"
+
+namespace frame
+{
+    /// \class DynamicResolution
+    /// \brief Scales the render resolution of RenderTargets marked with set_dynamic_resolution()
+    ///        to keep the GPU inside a frame time budget.
+    ///
+    /// GPU time comes from the GpuProfiler, so frames which are slow only on the CPU are left
+    /// alone, since resolution can't help them. Without profiler timings it falls back on the
+    /// frame's step interval. When the GPU runs over budget the scale drops straight to the size
+    /// which should fit, since fill cost goes with area, and when there's plenty of headroom it
+    /// creeps back up. Changes wait a few frames for the profiler's timings to catch up, so the
+    /// scale doesn't oscillate.
+    FRAME_SYSTEM(DynamicResolution, Node<RenderTarget>) {
+    public:
+        DynamicResolution(float budget_ms=16.6f, float min_scale=0.5f, float max_scale=1.0f)
+        : budget_ms(budget_ms), min_scale(min_scale), max_scale(max_scale), _scale(max_scale), cpu_ms(0.0f), frames_since_change(0) {}
+
+    public:
+
+        void step() {
+            cpu_ms = cpu_ms == 0.0f ? float(dt()) * 1000.0f : cpu_ms + (float(dt()) * 1000.0f - cpu_ms) * SMOOTHING;
+            float gpu_ms = float(GpuProfiler::get().gpu_total_ms());
+
+            // Without GPU timings, all we have to go on is the whole frame
+            if (gpu_ms == 0.0f)
+                gpu_ms = cpu_ms;
+
+            if (++frames_since_change >= SETTLE_FRAMES) {
+                float scale = next_scale(_scale, gpu_ms, budget_ms, min_scale, max_scale);
+                if (scale != _scale) {
+                    _scale = scale;
+                    frames_since_change = 0;
+                }
+            }
+
+            for (auto target : node<RenderTarget>())
+                if (target->dynamic_resolution())
+                    target->set_render_scale(_scale);
+        }
+
+        /// \brief The scale to render at next, given the GPU time a frame took at the current scale.
+        ///        Returns the current scale when it's close enough to the budget to leave alone.
+        static float next_scale(float scale, float gpu_ms, float budget_ms, float min_scale, float max_scale) {
+            float next = scale;
+            if (gpu_ms > budget_ms * OVER_BUDGET)
+                next = scale * std::sqrt(budget_ms * TARGET / gpu_ms);
+            else if (gpu_ms < budget_ms * UNDER_BUDGET)
+                next = scale + STEP_UP;
+
+            next = std::min(max_scale, std::max(min_scale, next));
+            return std::abs(next - scale) > 0.01f ? next : scale;
+        }
+
+    public:
+        DynamicResolution* set_budget(float budget_ms) { this->budget_ms = budget_ms; return this; }
+        float budget() const { return budget_ms; }
+        float scale() const { return _scale; }
+        float cpu_time() const { return cpu_ms; }
+
+    private:
+        static constexpr float SMOOTHING = 0.1f;
+        static constexpr unsigned int SETTLE_FRAMES = 8;
+        static constexpr float OVER_BUDGET = 0.95f;
+        static constexpr float UNDER_BUDGET = 0.75f;
+        static constexpr float TARGET = 0.85f;
+        static constexpr float STEP_UP = 0.05f;
+
+    private:
+        float budget_ms;
+        float min_scale;
+        float max_scale;
+        float _scale;
+        float cpu_ms;
+        unsigned int frames_since_change;
+    };
+}
@@ -27,18 +27,40 @@ namespace frame_gl
                 Shader::Preset::vert_standard(),
                 Shader::Preset::frag_colors());
 
+            // The outlines are rebuilt into the same mesh every frame
+            outline_mesh = new Mesh(4, 4);
+
             // Trigger callback whenever mouse moves
             window->mouse_position.listen(this, &GUIOperator::mouse_position_callback);
         }
 
         void teardown() {
             delete line_shader;
+            delete outline_mesh;
             window->mouse_position.ignore(this);
         }
 
         void step() {
             update_gui();
-            render_gui();
+
+            // Take the camera and the outline of each GUI element as they are now
+            Camera* camera = render->display_camera(gui_layer);
+            block = render->camera_block(camera);
+            outlines.clear();
+            for (auto rect : node<GUIRect>()) {
+                Outline outline = {
+                    { rect->top_left(), rect->top_right(), rect->bottom_right(), rect->bottom_left() },
+                    vec4(vec3(rect.entity() == focus ? 1.0f : 0.4f), 1.0f)
+                };
+                outlines.push_back(outline);
+            }
+            build_outlines();
+
+            // Draw over the GUI camera's target once the render graph runs
+            if (!camera->get<RenderTarget>()->prepare_overlay(!outlines.empty()))
+                return;
+            RenderGraph& graph = render->graph();
+            graph.add_pass("GUIOperator", graph.import(camera->target()->frame_buffer()), {}, [this]() { render_gui(); });
         }
 
     public:
@@ -79,34 +101,20 @@ namespace frame_gl
             }
         }
 
-        void render_gui() {
-
-            // Get the camera for the gui layer
-            Camera* camera = render->display_camera(gui_layer);
-
-            // Get ready to render stuff
-            camera->bind_target();
-            line_shader->bind();
-            line_shader->uniform(ShaderUniform::View, camera->view_matrix());
-            line_shader->uniform(ShaderUniform::Projection, camera->projection_matrix());
-            line_shader->uniform(ShaderUniform::Model, glm::mat4(1.0f));
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            glDisable(GL_CULL_FACE);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        void build_outlines() {
 
-            // Draw rectangles around each GUI element
-            size_t rect_count = node<GUIRect>().size();
-            Mesh mesh(4 * rect_count, 4 * rect_count);
+            // Put rectangles around each GUI element. This happens here rather than in the pass,
+            // which runs on the render thread and should only draw.
+            size_t rect_count = outlines.size();
+            if (rect_count == 0)
+                return;
+            outline_mesh->resize(4 * rect_count, 4 * rect_count);
             int index = 0;
-            for (auto rect : node<GUIRect>()) {
-                vec4 color(vec3(rect.entity() == focus ? 1.0f : 0.4f), 1.0f);
-                mesh.set_vertex(index + 0, vec3(rect->top_left(), 0.0f), color);
-                mesh.set_vertex(index + 1, vec3(rect->top_right(), 0.0f), color);
-                mesh.set_vertex(index + 2, vec3(rect->bottom_right(), 0.0f), color);
-                mesh.set_vertex(index + 3, vec3(rect->bottom_left(), 0.0f), color);
+            for (const Outline& outline : outlines) {
+                for (int i = 0; i < 4; ++i)
+                    outline_mesh->set_vertex(index + i, vec3(outline.corners[i], 0.0f), outline.color);
 
-                mesh.set_triangles({
+                outline_mesh->set_triangles({
                     ivec3(index, index+1, index+1),
                     ivec3(index+1, index+2, index+2),
                     ivec3(index+2, index+3, index+3),
@@ -115,16 +123,40 @@ namespace frame_gl
 
                 index += 4;
             }
-            mesh.render();
+        }
+
+        void render_gui() {
+
+            // Get ready to render stuff
+            render->bind_camera(block);
+            render->bind_object(render->push_object(glm::mat4(1.0f)));
+            render->flush_objects();
+            line_shader->bind();
+            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+            glDisable(GL_CULL_FACE);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+            // Draw the rectangles around each GUI element
+            outline_mesh->render();
 
             line_shader->unbind();
-            camera->unbind_target();
+            glDisable(GL_BLEND);
         }
 
+    private:
+        struct Outline {
+            vec2 corners[4];
+            vec4 color;
+        };
+
     private:
         Render* render;
         Window* window;
         Shader* line_shader;
+        Mesh* outline_mesh;
+        CameraBlock block;
+        std::vector<Outline> outlines;
         Entity* focus;
         vec2 mouse_position;
         int gui_layer;
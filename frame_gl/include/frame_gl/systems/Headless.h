@@ -0,0 +1,37 @@
+#pragma once
+#include "frame/System.h"
+#include "frame/Frame.h"
+#include "frame/Log.h"
+
+namespace frame
+{
+    /// \class Headless
+    /// \brief Stands in for a Window where there's no display server, on render servers and in CI.
+    ///
+    /// Creates an offscreen GL context through EGL, preferring Mesa's surfaceless platform so
+    /// that it works with the software rasterizer on machines without a GPU. Render then draws
+    /// into RenderTargets as usual, and nothing is ever presented. Requires frame_gl to be built
+    /// with FRAME_GL_EGL.
+    ///
+    /// Like Window, it must be added before any system or component which creates GL objects.
+    FRAME_SYSTEM(Headless) {
+    public:
+        /// \param frames Stop the frame after this many steps, or never if it's zero.
+        Headless(unsigned int frames=0);
+        ~Headless();
+
+    public:
+        bool valid() const { return context != nullptr; }
+        unsigned int frame_count() const { return _frame_count; }
+
+    protected:
+        virtual void step();
+
+    private:
+        void* display;
+        void* surface;
+        void* context;
+        unsigned int frames;
+        unsigned int _frame_count;
+    };
+}
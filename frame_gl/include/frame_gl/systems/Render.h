@@ -5,16 +5,94 @@
 #include <typeindex>
 #include <unordered_map>
 #include "frame/System.h"
+#include "frame/Task.h"
 #include "frame_gl/components/Camera.h"
 #include "frame_gl/components/Transform.h"
 #include "frame_gl/components/MeshRenderer.h"
 #include "frame_gl/data/Shader.h"
+#include "frame_gl/data/FrameBufferPool.h"
+#include "frame_gl/data/OcclusionBuffer.h"
+#include "frame_gl/data/RenderGraph.h"
+#include "frame_gl/data/RenderStats.h"
+#include "frame_gl/data/UniformBuffer.h"
+#include "frame_gl/data/UniformRing.h"
 #include "frame_gl/math.h"
+#include "frame_gl/parallel.h"
 
 namespace frame
 {
+    /// \class RasterizeOcclusion
+    /// \brief Helps rasterize the tiles of an OcclusionBuffer from a worker thread.
+    FRAME_TASK(RasterizeOcclusion) {
+    public:
+        RasterizeOcclusion() {}
+        RasterizeOcclusion(OcclusionBuffer* buffer, unsigned int generation) : buffer(buffer), generation(generation) {}
+
+    protected:
+        void run() { buffer->rasterize(generation); }
+
+    private:
+        OcclusionBuffer* buffer;
+        unsigned int generation;
+    };
+
+    class Render;
+
+    /// \struct RenderPacket
+    /// \brief Everything recorded about one draw, ready to be replayed on the GL thread.
+    ///
+    /// Packets keep what their renderer was drawing with, rather than the renderer itself, so
+    /// they can be replayed while the renderer is being changed for the next frame. They hold
+    /// their own references, so nothing they draw can be freed before they're replayed. The
+    /// references are taken on the main thread once recording is done, since worker threads
+    /// only note the renderer.
+    struct RenderPacket {
+        const MeshRenderer* renderer;
+        Resource<Mesh> mesh;
+        Resource<Texture> texture;
+        Resource<Shader> shader;
+        MeshRenderer::PolyMode poly_mode;
+        MeshRenderer::BlendMode blend_mode;
+        bool cull_back;
+        unsigned int layer;
+        ObjectBlock constants;
+        float depth;
+    };
+
+    /// \class RecordPackets
+    /// \brief Helps record the render packets of a camera from a worker thread.
+    FRAME_TASK(RecordPackets) {
+    public:
+        RecordPackets() {}
+        RecordPackets(Render* render, unsigned int generation) : render(render), generation(generation) {}
+
+    protected:
+        void run();
+
+    private:
+        Render* render;
+        unsigned int generation;
+    };
+
     /// \class Render
     /// \brief Draws all MeshRenderer components to all Camera target textures.
+    ///
+    /// Renderers are kept in one bucket per layer, so each camera only ever looks at the
+    /// buckets of its own layers. Each camera is then drawn in two phases. Recording reads
+    /// transforms, skips occluded renderers and packs per-object constants into one packet
+    /// list per slice of the renderers, spread across worker threads with RecordPackets tasks. Submission then replays the merged
+    /// lists on the GL thread, which is the only one that ever calls into GL. Opaque objects are
+    /// submitted front to back, optionally after a depth-only prepass, and blended objects follow
+    /// back to front.
+    ///
+    /// Drawing itself is deferred: each camera declares a pass on the render graph, alongside
+    /// the passes of other systems drawing to the same targets, and the whole graph runs once
+    /// the frame is ready to be shown. The Window or Headless system runs it with execute_graph(),
+    /// and if neither does, the next step() runs whatever is left over.
+    ///
+    /// Objects whose shader is still being compiled by the driver are drawn with
+    /// Shader::Preset::placeholder() until it's ready, instead of holding up the frame. Shaders,
+    /// including the indirect variants, are only ever made in step(), so passes just draw.
     FRAME_SYSTEM(Render, Node<RenderTarget>, Node<Camera, RenderTarget>, Node<MeshRenderer>) {
 
     public:
@@ -34,6 +112,20 @@ namespace frame
 
         enum Mode { Normal, Wireframe };
 
+        /// \brief How draws are handed to GL. Immediate binds and draws each object in turn,
+        ///        while Indirect batches objects sharing a shader, mesh and state into a single
+        ///        glMultiDrawElementsIndirect call.
+        enum Submission { Immediate, Indirect };
+
+        /// \brief Layout of a single GL_DRAW_INDIRECT_BUFFER entry.
+        struct DrawIndirectCommand {
+            unsigned int count;
+            unsigned int instance_count;
+            unsigned int first_index;
+            int base_vertex;
+            unsigned int base_instance;
+        };
+
     public:
         const unsigned int MAX_LAYERS = 32;
 
@@ -41,9 +133,19 @@ namespace frame
         Render(bool auto_clear=true)
         :   display_targets(std::vector<RenderTarget*>(MAX_LAYERS, nullptr)),
             display_cameras(std::vector<Camera*>(MAX_LAYERS, nullptr)),
+            layer_buckets(MAX_LAYERS),
             /*_display_target(nullptr), _display_camera(nullptr), */
             auto_clear(auto_clear),
-            _mode(Normal) {}
+            _mode(Normal),
+            _submission(Immediate),
+            _occlusion_culling(false),
+            _depth_prepass(false),
+            _time(0.0f),
+            camera_buffer(nullptr),
+            object_ring(nullptr),
+            indirect_buffer(0),
+            draw_data_buffer(0),
+            _render_thread(nullptr) {}
 
     public:
 
@@ -56,10 +158,78 @@ namespace frame
             return (layer < MAX_LAYERS) ? display_targets[layer] : nullptr;
         }
 
+        /// \brief Write the camera's matrices to the shared Camera uniform block and bind it, for
+        ///        systems which draw to a camera's target outside of Render::step().
+        void bind_camera(Camera* camera) { bind_camera(camera_block(camera)); }
+
+        /// \brief Bind camera matrices taken earlier with camera_block(). Passes use this so that
+        ///        they draw with the camera as it was when they were declared.
+        void bind_camera(const CameraBlock& block);
+
+        /// \brief Take the matrices of a camera as they are now.
+        CameraBlock camera_block(Camera* camera) const;
+
+        /// \brief Pack the constants of one draw into this frame's object ring.
+        /// \return the offset to pass to bind_object() once the constants have been flushed.
+        size_t push_object(const mat4& model, const vec4& color=vec4(1.0f), const vec4& params=vec4(0.0f));
+
+        /// \brief Upload all objects pushed since the last flush.
+        void flush_objects() { object_ring->flush(); }
+
+        /// \brief Bind the constants of one draw to the Object uniform block.
+        void bind_object(size_t offset) { object_ring->bind(ObjectBlock::Binding, offset, sizeof(ObjectBlock)); }
+
+        /// \brief Add a renderer to the bucket of its layer. Called by MeshRenderer when it's set up.
+        void add_renderer(MeshRenderer* renderer);
+
+        /// \brief Remove a renderer from the bucket of its layer.
+        void remove_renderer(MeshRenderer* renderer);
+
+        /// \brief Record the packets of any unclaimed slices of the current camera.
+        void record(unsigned int generation);
+
         Render* set_mode(Mode mode) { _mode = mode; return this; }
 
         Mode mode() const { return _mode; }
 
+        /// \brief Switch between immediate and multi-draw-indirect submission. Objects whose shaders
+        ///        aren't built on Shader::Preset::vert_standard() are always drawn immediately.
+        Render* set_submission(Submission submission) { _submission = submission; return this; }
+
+        Submission submission() const { return _submission; }
+
+        /// \brief Rasterize occluder meshes on the CPU for each camera, and skip drawing
+        ///        anything whose bounds are hidden behind them.
+        Render* set_occlusion_culling(bool occlusion_culling) { _occlusion_culling = occlusion_culling; return this; }
+
+        bool occlusion_culling() const { return _occlusion_culling; }
+
+        const OcclusionBuffer& occlusion_buffer() const { return occlusion; }
+
+        /// \brief Draw the depth of opaque objects with a position-only shader before shading them,
+        ///        so that fragment-heavy shaders only run once per pixel.
+        Render* set_depth_prepass(bool depth_prepass) { _depth_prepass = depth_prepass; return this; }
+
+        bool depth_prepass() const { return _depth_prepass; }
+
+        /// \brief Frame buffers for passes which only need one for part of a frame.
+        FrameBufferPool& target_pool() { return transient_targets; }
+
+        /// \brief The passes of this frame. Systems which draw to a camera's target declare their
+        ///        passes here rather than binding the target themselves.
+        RenderGraph& graph() { return _graph; }
+
+        /// \brief Run every pass declared this frame.
+        void execute_graph();
+
+        /// \brief The thread the graph is being run on, if it isn't run on this one. Each step()
+        ///        starts by waiting for it, so the graph of the last frame is finished before
+        ///        anything is recorded for the next. Set by Window::set_render_thread().
+        Render* set_render_thread(RenderThread* render_thread) { _render_thread = render_thread; return this; }
+
+        /// \brief Counters of the work done by the last frame whose graph has run, split by camera and by layer.
+        const RenderStats& stats() const { return _stats; }
+
         /*
         /// \brief Set a global uniform
         template <typename T>
@@ -89,16 +259,72 @@ namespace frame
         */
 
     protected:
+        virtual void setup();
+        virtual void teardown();
         virtual void step();
 
         void load_prototypes(std::back_insert_iterator< std::vector< CommandPrototype > >& commands);
         void handle(Command command);
 
+    private:
+        void cull_occluded(Camera* camera, std::vector<bool>& visible);
+        size_t signature(Camera* camera, RenderTarget* target);
+        void record_slice(size_t slice);
+        void render_immediate(const CameraBlock& camera, const std::vector<RenderPacket>& packets, const std::vector<size_t>& offsets);
+        void render_indirect(const std::vector<RenderPacket>& packets);
+        void render_depth(const std::vector<RenderPacket>& packets, const std::vector<size_t>& offsets);
+        void render_camera(size_t index);
+        void batch_packets(std::vector<RenderPacket>& packets, std::vector<RenderPacket>& batched);
+        Resource<Shader> indirect_shader(const Resource<Shader>& shader);
+        void count_layers(const std::vector<RenderPacket>& packets);
+        size_t count_culled();
+
+    private:
+        /// \brief Everything recorded for one camera, kept until its pass runs.
+        struct CameraPass {
+            std::string name;
+            CameraBlock camera;
+            size_t stats_index;
+            std::vector<RenderPacket> packets;
+            std::vector<RenderPacket> batched_packets;
+            std::vector<RenderPacket> blended_packets;
+            std::vector<size_t> offsets;
+            std::vector<size_t> batched_offsets;
+            std::vector<size_t> blended_offsets;
+        };
+
     private:
         std::vector<RenderTarget*> display_targets;
         std::vector<Camera*> display_cameras;
+        std::vector< std::vector<MeshRenderer*> > layer_buckets;
         //std::unordered_map< std::string, std::shared_ptr< GlobalPropertyBase > > global_uniforms;
         bool auto_clear;
         Mode _mode;
+        Submission _submission;
+        bool _occlusion_culling;
+        bool _depth_prepass;
+        OcclusionBuffer occlusion;
+        std::vector<bool> visible;
+        float _time;
+        UniformBuffer* camera_buffer;
+        UniformRing* object_ring;
+        std::vector<MeshRenderer*> renderers;
+        std::vector< std::vector<RenderPacket> > packet_lists;
+        std::vector<CameraPass> camera_passes;
+        mat4 record_view;
+        WorkQueue record_work;
+        std::unordered_map< const Shader*, std::pair< Resource<Shader>, Resource<Shader> > > indirect_shaders;
+        Resource<ShaderPart> standard_vertex;
+        Resource<Shader> placeholder_shader;
+        Resource<Shader> depth_shader;
+        std::vector<DrawIndirectCommand> indirect_commands;
+        std::vector<mat4> draw_data;
+        unsigned int indirect_buffer;
+        unsigned int draw_data_buffer;
+        RenderStats _stats;
+        RenderStats frame_stats;
+        FrameBufferPool transient_targets;
+        RenderGraph _graph;
+        RenderThread* _render_thread;
     };
 }
\ No newline at end of file
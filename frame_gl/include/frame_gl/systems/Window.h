@@ -1,5 +1,8 @@
 #pragma once
+#include <chrono>
+#include <deque>
 #include <string>
+#include <vector>
 #include <GLFW/glfw3.h>
 #include "frame/config.h"
 #include "frame/System.h"
@@ -11,7 +14,9 @@
 #include "frame_gl/components/RenderTarget.h"
 #include "frame_gl/data/Shader.h"
 #include "frame_gl/data/Mesh.h"
+#include "frame_gl/data/RenderGraph.h"
 #include "frame_gl/math.h"
+#include "frame_gl/parallel.h"
 
 namespace frame
 {
@@ -19,6 +24,16 @@ namespace frame
     public:
         enum FitMode { Stretch, Fit, Fill, Center };
 
+        /// \brief Time from the first input event a frame could react to until that frame's
+        ///        buffers were swapped. With frames in flight limited to one, the swap returns
+        ///        about when the frame reaches the screen.
+        struct Latency {
+            double last_ms;
+            double average_ms;
+            double max_ms;
+            size_t samples;
+        };
+
     public:
         Window(ivec2 size=ivec2(0), bool resizeable=true, FitMode fit_mode=Fit, bool vsync=false, const vec3& clear_color=vec3(0.5f));
         ~Window();
@@ -28,6 +43,28 @@ namespace frame
         const vec2& area() const { return _area; }
         void set_clear_color(const vec3& clear_color) { this->clear_color = clear_color; };
 
+        /// \brief Run the render graph and swap buffers on a thread of their own, so that systems
+        ///        which step between the Window and the Render system overlap with the GL work of
+        ///        the frame before. Those systems mustn't call into GL, declare render passes,
+        ///        or destroy cameras or render targets, since the GL thread may still be drawing them.
+        void set_render_thread(bool threaded);
+
+        bool threaded() const { return render_thread != nullptr; }
+
+        /// \brief Cap the frame rate, sleeping for most of the wait and spinning out the rest, which
+        ///        keeps frames evenly spaced where sleeping alone would overshoot. 0 turns it off.
+        void set_frame_limit(double frames_per_second) { frame_limit = frames_per_second; }
+
+        /// \brief Stop the driver queueing more than this many frames ahead of the GPU, by waiting
+        ///        on a fence from that many swaps ago. Fewer frames in flight means less input
+        ///        latency, for a little less throughput. 0 leaves it up to the driver.
+        void set_max_frames_in_flight(unsigned int max_frames_in_flight) { this->max_frames_in_flight = max_frames_in_flight; }
+
+        double frame_limit_fps() const { return frame_limit; }
+        unsigned int frames_in_flight() const { return max_frames_in_flight; }
+        const Latency& latency() const { return _latency; }
+        void reset_latency();
+
     public:
         //
         // TODO: This is bad - make a better mechanism!!!
@@ -39,9 +76,37 @@ namespace frame
         virtual void step();
         virtual void teardown();
 
+        void load_prototypes(std::back_insert_iterator< std::vector< CommandPrototype > >& commands);
+        void handle(Command command);
+
     private:
+        struct DisplayBuffer;
+        void update_display_buffers();
+        bool can_blit(const DisplayBuffer& buffer, const ivec2& window_size) const;
+        bool composite(const std::vector<DisplayBuffer>& buffers, const ivec2& window_size, const RenderGraph* graph);
+        void present();
+        void limit_frame_rate();
+        void limit_frames_in_flight();
+        void input_received();
+        void record_latency();
         void calculate_buffer_transform(RenderTarget* buffer, mat4& transform);
 
+        /// \brief A display target, along with the transform it was last drawn with and the sizes
+        ///        that transform was worked out for. The viewport and allocation are copied every
+        ///        frame, so the composite never reads sizes the main thread may be changing.
+        struct DisplayBuffer {
+            RenderTarget* target;
+            ivec2 size;
+            ivec2 window_size;
+            mat4 transform;
+            ivec2 viewport;
+            ivec2 allocation;
+
+            /// \brief The transient target a multisampled buffer is resolved into before it's
+            ///        composited, or the screen's handle if the buffer is sampled as it is.
+            RenderGraph::Handle resolved;
+        };
+
     public:
         static void resize_callback(GLFWwindow* window, int width, int height);
         static void keyboard_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
@@ -65,12 +130,31 @@ namespace frame
         GLFWwindow* window;
         ivec2 _size;
         vec2 _area;
-        glm::mat4 transform;
+        std::vector<RenderTarget*> display_targets;
+        std::vector<DisplayBuffer> display_buffers;
         int transform_location;
+        int uv_scale_location;
+        int uv_max_location;
         FitMode fit_mode;
         vec3 clear_color;
         bool vsync;
         Mesh* mesh;
         Shader* shader;
+        RenderThread* render_thread;
+        bool composited;
+        double frame_limit;
+        std::chrono::steady_clock::time_point next_present;
+        unsigned int max_frames_in_flight;
+        std::deque<void*> frame_fences;
+
+        // Input timestamps pass from the event callbacks, to the frame which reacts to them, to its swap
+        bool input_pending;
+        std::chrono::steady_clock::time_point input_time;
+        bool frame_has_input;
+        std::chrono::steady_clock::time_point frame_input_time;
+        bool presented_input;
+        std::chrono::steady_clock::time_point presented_input_time;
+        std::chrono::steady_clock::time_point presented_time;
+        Latency _latency;
     };
 }
\ No newline at end of file
@@ -1,13 +1,15 @@
 #define GLEW_STATIC
+#include <cstring>
 #include <GL/glew.h>
 #include "frame/Log.h"
 #include "frame_gl/data/FrameBuffer.h"
+#include "frame_gl/data/RenderStats.h"
 #include "frame_gl/data/Texture.h"
 #include "frame_gl/error.h"
 using namespace frame;
 
-FrameBuffer::FrameBuffer(const ivec2& size, bool depth, const vec4& clear_color, bool multisample)
-    : _size(size), _multisample(multisample), _depth(depth), _clear_color(clear_color) {
+FrameBuffer::FrameBuffer(const ivec2& size, bool depth, const vec4& clear_color, bool multisample, Texture::Format color_format, DepthFormat depth_format)
+    : _size(size), _allocation(size), _multisample(multisample), _depth(depth), _color_format(color_format), _depth_format(depth_format), _clear_color(clear_color), _render_scale(1.0f), next_read(0) {
 
     // Create the frame buffer object
     glGenFramebuffers(1, &frame_buffer_id);
@@ -16,13 +18,11 @@ FrameBuffer::FrameBuffer(const ivec2& size, bool depth, const vec4& clear_color,
     // Create a render buffer, and attach it to FBO's depth attachment
     if (_depth) {
         glGenRenderbuffers(1, &depth_buffer_id);
-        glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_id);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, size.x, size.y);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_buffer_id);
+        allocate_depth();
     }
 
     // Create texture and attach FBO's color 0 attachment
-    texture = new Texture(size, multisample);
+    texture = new Texture(size, multisample, color_format);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture->target(), texture->id(), 0);
 
     // Check frame buffer status
@@ -41,26 +41,45 @@ FrameBuffer::FrameBuffer(const ivec2& size, bool depth, const vec4& clear_color,
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-FrameBuffer::~FrameBuffer() { delete texture; }
+FrameBuffer::~FrameBuffer() {
+    for (Read& read : reads)
+        glDeleteSync((GLsync)read.fence);
+    if (!read_buffers.empty())
+        glDeleteBuffers((GLsizei)read_buffers.size(), read_buffers.data());
+    delete texture;
+    if (_depth) glDeleteRenderbuffers(1, &depth_buffer_id);
+    glDeleteFramebuffers(1, &frame_buffer_id);
+}
 
 void FrameBuffer::set_size(const ivec2& size) {
-
     _size = size;
 
+    // Only reallocate if the new size doesn't fit in what we've already got, or if it would
+    // leave most of it unused, so one large frame doesn't hold on to its memory for good
+    ivec2 allocation = fit_allocation(_allocation, size);
+    if (allocation != _allocation)
+        allocate(allocation);
+}
+
+void FrameBuffer::trim() {
+    if (_allocation != _size)
+        allocate(_size);
+}
+
+void FrameBuffer::allocate(const ivec2& allocation) {
+    _allocation = allocation;
+
     glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_id);
 
     // Resize the depth buffer if needed
-    if (_depth) {
-        glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_id);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _size.x, _size.y);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_buffer_id);
-    }
+    if (_depth)
+        allocate_depth();
 
     // Delete the old texture
     delete texture;
 
     // Make a new texture
-    texture = new Texture(_size, _multisample);
+    texture = new Texture(_allocation, _multisample, _color_format);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture->target(), texture->id(), 0);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -72,31 +91,54 @@ void FrameBuffer::bind_target(bool clear) {
 
     // Bind the frame buffer
     glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_id);
+    ++RenderStats::live().fbo_binds;
+
+    reset_state(clear);
+}
+
+void FrameBuffer::reset_state(bool clear) {
 
-    // Set the viewport
-    glViewport(0, 0, _size.x, _size.y);
+    // Set the viewport, which only covers part of the buffer when it's scaled down
+    ivec2 viewport = this->viewport();
+    glViewport(0, 0, viewport.x, viewport.y);
 
     // Set up OpenGL state
     if (_depth) glEnable(GL_DEPTH_TEST);
     else glDisable(GL_DEPTH_TEST);
-    //glDisable(GL_BLEND);
     glDisable(GL_STENCIL_TEST);
 
-    // TODO: Make blend optional
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // Blending is off until a pass which needs it turns it on
+    glDisable(GL_BLEND);
+
+    // sRGB targets are gamma encoded as they're written
+    if (texture->srgb()) glEnable(GL_FRAMEBUFFER_SRGB);
+    else glDisable(GL_FRAMEBUFFER_SRGB);
 
     glEnable(GL_MULTISAMPLE);
 
     // Clear the frame buffer if necessary
     if (clear) {
         glClearColor(_clear_color.r, _clear_color.g, _clear_color.b, _clear_color.a);
-        glClear(GL_COLOR_BUFFER_BIT | (_depth ? GL_DEPTH_BUFFER_BIT : 0));
+        glClear(GL_COLOR_BUFFER_BIT | (_depth ? GL_DEPTH_BUFFER_BIT : 0) | (stencil() ? GL_STENCIL_BUFFER_BIT : 0));
     }
 
     gl_check();
 }
 
+void FrameBuffer::allocate_depth() {
+    GLenum format = GL_DEPTH_COMPONENT24;
+    if (_depth_format == Depth16) format = GL_DEPTH_COMPONENT16;
+    else if (_depth_format == Depth32F) format = GL_DEPTH_COMPONENT32F;
+    else if (_depth_format == Depth24Stencil8) format = GL_DEPTH24_STENCIL8;
+    else if (_depth_format == Depth32FStencil8) format = GL_DEPTH32F_STENCIL8;
+
+    // Formats with stencil go on the combined attachment. The frame buffer must already be bound.
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_id);
+    glRenderbufferStorage(GL_RENDERBUFFER, format, _allocation.x, _allocation.y);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, stencil() ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_buffer_id);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
 void FrameBuffer::bind_texture(unsigned int texture_unit) {
     texture->bind(texture_unit);
 }
@@ -105,6 +147,115 @@ void FrameBuffer::unbind_target() {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void FrameBuffer::blit_to_screen(const ivec2& viewport, const ivec2& screen_size) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, frame_buffer_id);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    ++RenderStats::live().fbo_binds;
+
+    // Blits of linear targets are copies, and must not be encoded again if an sRGB target
+    // was the last one bound
+    glDisable(GL_FRAMEBUFFER_SRGB);
+    glBlitFramebuffer(0, 0, viewport.x, viewport.y, 0, 0, screen_size.x, screen_size.y,
+                      GL_COLOR_BUFFER_BIT, viewport == screen_size ? GL_NEAREST : GL_LINEAR);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    gl_check();
+}
+
+void FrameBuffer::resolve_to(FrameBuffer* target, const ivec2& viewport) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, frame_buffer_id);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target->frame_buffer_id);
+    ++RenderStats::live().fbo_binds;
+
+    // A straight copy, so nothing is encoded on the way
+    glDisable(GL_FRAMEBUFFER_SRGB);
+    glBlitFramebuffer(0, 0, viewport.x, viewport.y, 0, 0, viewport.x, viewport.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target->frame_buffer_id);
+    gl_check();
+}
+
 void FrameBuffer::unbind_texture() {
     texture->unbind();
 }
+
+void FrameBuffer::read_async(const ReadCallback& callback) {
+    if (_multisample) {
+        Log::error("Can't read back a multisampled frame buffer");
+        return;
+    }
+
+    // Make the ring the first time it's needed
+    if (read_buffers.empty()) {
+        read_buffers.resize(READ_BUFFERS);
+        glGenBuffers(READ_BUFFERS, read_buffers.data());
+    }
+
+    // With every buffer in flight, the oldest read has to be finished before its buffer can be reused
+    if (reads.size() == READ_BUFFERS) {
+        glClientWaitSync((GLsync)reads.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        deliver(reads.front());
+        reads.pop_front();
+    }
+
+    // Buffers are handed out in turn, so the next one is never in flight
+    Read read;
+    read.buffer = read_buffers[next_read];
+    next_read = (next_read + 1) % READ_BUFFERS;
+    read.size = viewport();
+    read.callback = callback;
+
+    // Start copying the pixels into the buffer. This returns right away.
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, frame_buffer_id);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, read.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, 4 * read.size.x * read.size.y, 0, GL_STREAM_READ);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, read.size.x, read.size.y, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    // Flush so the fence reaches the GPU even if nothing swaps buffers, as when headless,
+    // since poll_reads() only peeks at it
+    read.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    reads.push_back(read);
+    gl_check();
+}
+
+void FrameBuffer::poll_reads() {
+    while (!reads.empty()) {
+        GLenum status = glClientWaitSync((GLsync)reads.front().fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        deliver(reads.front());
+        reads.pop_front();
+    }
+}
+
+void FrameBuffer::finish_reads() {
+    while (!reads.empty()) {
+        glClientWaitSync((GLsync)reads.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        deliver(reads.front());
+        reads.pop_front();
+    }
+}
+
+void FrameBuffer::deliver(Read& read) {
+    glDeleteSync((GLsync)read.fence);
+    read.fence = nullptr;
+
+    // The GPU is done with the buffer, so mapping it doesn't stall
+    size_t size = 4 * read.size.x * read.size.y;
+    read_pixels.resize(size);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, read.buffer);
+    if (void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT)) {
+        memcpy(read_pixels.data(), data, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    gl_check();
+
+    if (read.callback)
+        read.callback(read.size, read_pixels);
+}
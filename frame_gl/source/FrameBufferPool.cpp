@@ -0,0 +1,75 @@
+#include <string>
+#include "frame/Log.h"
+#include "frame_gl/data/FrameBufferPool.h"
+using namespace frame;
+
+FrameBuffer* FrameBufferPool::acquire(const ivec2& size, Texture::Format format, bool depth, FrameBuffer::DepthFormat depth_format) {
+
+    // Find the smallest free buffer of the same formats which the size fits in
+    Entry* best = nullptr;
+    for (Entry& entry : entries) {
+        FrameBuffer* buffer = entry.buffer;
+        if (entry.in_use ||
+            buffer->color_format() != format ||
+            buffer->depth() != depth ||
+            (depth && buffer->depth_format() != depth_format) ||
+            buffer->allocation().x < size.x || buffer->allocation().y < size.y)
+            continue;
+
+        if (!best || buffer->allocation().x * buffer->allocation().y < best->buffer->allocation().x * best->buffer->allocation().y)
+            best = &entry;
+    }
+
+    // Otherwise make a new one
+    if (!best) {
+        Entry entry = { new FrameBuffer(size, depth, vec4(0.0f), false, format, depth_format), false, frame };
+        entries.push_back(entry);
+        best = &entries.back();
+    }
+
+    best->in_use = true;
+    best->last_used = frame;
+    best->buffer->set_size(size);
+    best->buffer->set_render_scale(1.0f);
+    return best->buffer;
+}
+
+void FrameBufferPool::release(FrameBuffer* buffer) {
+    for (Entry& entry : entries) {
+        if (entry.buffer == buffer) {
+            entry.in_use = false;
+            entry.last_used = frame;
+            return;
+        }
+    }
+
+    Log::warning("Released a frame buffer which didn't come from this pool");
+}
+
+void FrameBufferPool::next_frame() {
+    ++frame;
+
+    // Swap idle buffers out to the back, and delete them
+    for (size_t i = 0; i < entries.size();) {
+        if (!entries[i].in_use && frame - entries[i].last_used > max_idle_frames) {
+            delete entries[i].buffer;
+            entries[i] = entries.back();
+            entries.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+void FrameBufferPool::clear() {
+    for (Entry& entry : entries)
+        delete entry.buffer;
+    entries.clear();
+}
+
+size_t FrameBufferPool::in_use() const {
+    size_t count = 0;
+    for (const Entry& entry : entries)
+        if (entry.in_use) ++count;
+    return count;
+}
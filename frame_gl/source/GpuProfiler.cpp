@@ -0,0 +1,122 @@
+#define GLEW_STATIC
+#include <cstdio>
+#include <GL/glew.h>
+#include "frame_gl/data/GpuProfiler.h"
+#include "frame_gl/error.h"
+using namespace frame;
+
+namespace
+{
+    // Weight of each new sample in the rolling averages
+    const double SMOOTHING = 0.1;
+
+    double smooth(double average, double sample, bool first) {
+        return first ? sample : average + (sample - average) * SMOOTHING;
+    }
+}
+
+GpuProfiler& GpuProfiler::get() {
+    static GpuProfiler profiler;
+    return profiler;
+}
+
+void GpuProfiler::begin(const std::string& name) {
+    auto it = spans.find(name);
+
+    // Queries can only be made once there's a context, so spans are set up the first time they're used
+    if (it == spans.end()) {
+        Span span;
+        glGenQueries(FRAMES * 2, &span.queries[0][0]);
+        for (unsigned int i = 0; i < FRAMES; ++i) {
+            span.pending[i] = false;
+            span.begun[i] = 0;
+        }
+        it = spans.insert(std::make_pair(name, span)).first;
+    }
+
+    glQueryCounter(it->second.queries[frame][0], GL_TIMESTAMP);
+    it->second.begun[frame] = frame_number;
+    it->second.cpu_begin = std::chrono::steady_clock::now();
+}
+
+void GpuProfiler::end(const std::string& name) {
+    auto it = spans.find(name);
+    if (it == spans.end())
+        return;
+
+    Span& span = it->second;
+    glQueryCounter(span.queries[frame][1], GL_TIMESTAMP);
+    span.pending[frame] = true;
+
+    // CPU time is known right away
+    double cpu_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - span.cpu_begin).count();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto timing = _timings.find(name);
+    if (timing == _timings.end()) {
+        Timing first = { cpu_ms, 0.0, 0, 0 };
+        _timings.insert(std::make_pair(name, first));
+    } else {
+        timing->second.cpu_ms = smooth(timing->second.cpu_ms, cpu_ms, false);
+    }
+}
+
+void GpuProfiler::next_frame() {
+    frame = (frame + 1) % FRAMES;
+    ++frame_number;
+
+    // The slot we're about to reuse was written this many frames ago
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        read_frame = frame_number >= FRAMES ? frame_number - FRAMES : 0;
+    }
+
+    // Collect whatever the GPU has finished from the slot we're about to reuse
+    for (auto& it : spans) {
+        Span& span = it.second;
+        if (!span.pending[frame])
+            continue;
+        span.pending[frame] = false;
+
+        GLint available = 0;
+        glGetQueryObjectiv(span.queries[frame][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+
+        GLuint64 begin_ns = 0, end_ns = 0;
+        glGetQueryObjectui64v(span.queries[frame][0], GL_QUERY_RESULT, &begin_ns);
+        glGetQueryObjectui64v(span.queries[frame][1], GL_QUERY_RESULT, &end_ns);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Timing& timing = _timings[it.first];
+        timing.gpu_ms = smooth(timing.gpu_ms, double(end_ns - begin_ns) * 1e-6, timing.samples == 0);
+        timing.frame = span.begun[frame];
+        ++timing.samples;
+    }
+
+    gl_check();
+}
+
+std::map<std::string, GpuProfiler::Timing> GpuProfiler::timings() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return _timings;
+}
+
+double GpuProfiler::gpu_total_ms() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    double total = 0.0;
+    for (auto& it : _timings)
+        if (it.second.samples > 0 && it.second.frame == read_frame)
+            total += it.second.gpu_ms;
+    return total;
+}
+
+std::vector<std::string> GpuProfiler::report() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> lines;
+    char line[64];
+    for (auto& it : _timings) {
+        snprintf(line, sizeof(line), ": cpu %.3fms, gpu %.3fms", it.second.cpu_ms, it.second.gpu_ms);
+        lines.push_back(it.first + line);
+    }
+    return lines;
+}
@@ -0,0 +1,161 @@
+#define GLEW_STATIC
+#include <string>
+#include <cstring>
+#include <GL/glew.h>
+#if FRAME_GL_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include "frame_gl/systems/Headless.h"
+#include "frame_gl/systems/Render.h"
+#include "frame_gl/data/GpuProfiler.h"
+#include "frame_gl/error.h"
+using namespace frame;
+
+#if FRAME_GL_EGL
+
+namespace
+{
+    bool has_extension(EGLDisplay display, const char* name) {
+        const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+        return extensions && strstr(extensions, name);
+    }
+
+    EGLDisplay open_display() {
+
+        // Mesa's surfaceless platform needs neither a display server nor a GPU
+        if (has_extension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+            auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (get_platform_display) {
+                EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+                if (display != EGL_NO_DISPLAY)
+                    return display;
+            }
+        }
+
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+}
+
+Headless::Headless(unsigned int frames)
+: display(nullptr), surface(nullptr), context(nullptr), frames(frames), _frame_count(0) {
+
+    EGLDisplay egl_display = open_display();
+    EGLint major, minor;
+    if (egl_display == EGL_NO_DISPLAY || !eglInitialize(egl_display, &major, &minor)) {
+        Log::error("Failed to open an EGL display");
+        return;
+    }
+    display = egl_display;
+    Log::success("EGL initialized: " + std::to_string(major) + "." + std::to_string(minor) + " " + std::string(eglQueryString(egl_display, EGL_VENDOR)));
+
+    // Everything is drawn into render targets, so the default framebuffer's format hardly matters
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(egl_display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+        Log::error("No EGL config supports offscreen OpenGL rendering");
+        return;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        Log::error("EGL can't bind the OpenGL API");
+        return;
+    }
+
+    // Ask for 4.3 so that indirect submission is available, but settle for 3.3
+    const EGLint versions[][2] = { { 4, 3 }, { 3, 3 } };
+    EGLContext egl_context = EGL_NO_CONTEXT;
+    for (auto& version : versions) {
+        const EGLint context_attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, version[0],
+            EGL_CONTEXT_MINOR_VERSION, version[1],
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attributes);
+        if (egl_context != EGL_NO_CONTEXT)
+            break;
+    }
+    if (egl_context == EGL_NO_CONTEXT) {
+        Log::error("Failed to create an OpenGL 3.3 context through EGL");
+        return;
+    }
+
+    // Skip the surface entirely where we can, and otherwise make do with a tiny pbuffer
+    EGLSurface egl_surface = EGL_NO_SURFACE;
+    if (!has_extension(egl_display, "EGL_KHR_surfaceless_context")) {
+        const EGLint pbuffer_attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        egl_surface = eglCreatePbufferSurface(egl_display, config, pbuffer_attributes);
+        if (egl_surface == EGL_NO_SURFACE) {
+            Log::error("Failed to create an EGL pbuffer surface");
+            eglDestroyContext(egl_display, egl_context);
+            return;
+        }
+        surface = egl_surface;
+    }
+
+    if (!eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context)) {
+        Log::error("Failed to make the EGL context current");
+        eglDestroyContext(egl_display, egl_context);
+        return;
+    }
+    context = egl_context;
+    Log::success("Headless context created: " + std::string((const char*)glGetString(GL_VERSION)));
+
+    // Core contexts need GLEW to look past the extension string. Without GLX, GLEW complains
+    // that there's no GLX display, but by then it has loaded everything we need.
+    glewExperimental = GL_TRUE;
+    auto status = glewInit();
+    #ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (status == GLEW_ERROR_NO_GLX_DISPLAY) status = GLEW_OK;
+    #endif
+    if (status != GLEW_OK)
+        Log::error("GL Extensions failed to initialize: " + std::string((char*)glewGetErrorString(status)));
+    else
+        Log::success("GL Extensions initialized: GLEW " + std::string((char*)glewGetString(GLEW_VERSION)));
+
+    // GLEW may leave a harmless error behind
+    glGetError();
+    gl_check();
+}
+
+Headless::~Headless() {
+    if (!display) return;
+
+    eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface) eglDestroySurface((EGLDisplay)display, (EGLSurface)surface);
+    if (context) eglDestroyContext((EGLDisplay)display, (EGLContext)context);
+    eglTerminate((EGLDisplay)display);
+}
+
+#else
+
+Headless::Headless(unsigned int frames)
+: display(nullptr), surface(nullptr), context(nullptr), frames(frames), _frame_count(0) {
+    Log::error("Headless rendering needs frame_gl to be built with FRAME_GL_EGL");
+}
+
+Headless::~Headless() {}
+
+#endif
+
+void Headless::step() {
+
+    // There's nothing to present, but this is still the end of a frame
+    if (valid()) {
+        if (Render* render = frame()->systems().get<Render>())
+            render->execute_graph();
+        GpuProfiler::get().next_frame();
+    }
+
+    ++_frame_count;
+    if (frames != 0 && _frame_count >= frames)
+        frame().stop();
+}
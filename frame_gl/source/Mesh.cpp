@@ -13,7 +13,9 @@
 #include "frame/Log.h"
 #include "frame/Resource.h"
 #include "frame_gl/data/Mesh.h"
+#include "frame_gl/data/RenderStats.h"
 #include "frame_gl/math.h"
+#include "frame_gl/context.h"
 #include "frame_gl/error.h"
 using namespace frame;
 
@@ -27,9 +29,9 @@ VertexAttributeSet VertexAttributeSet::operator+(const VertexAttributeSet& other
 }
 
 Mesh::Mesh(VertexAttributeSet attributes, size_t vertex_count, size_t triangle_count, bool dynamic_triangles) :
-    _attributes(attributes), _dynamic_triangles(dynamic_triangles), vao(0), block(0), _finalized(false) {
+    _attributes(attributes), _dynamic_triangles(dynamic_triangles), vao(0), block(0), _finalized(false), _bounds_valid(false), _version(0) {
 
-    if (glfwGetCurrentContext() == 0)
+    if (!gl_context_current())
         Log::error("Can't create a mesh outside of an OpenGL context!");
 
     // Set up empty buffers, & get space for them in gfx
@@ -50,12 +52,18 @@ void Mesh::render() const {
 
 void Mesh::draw() const {
     glDrawElements(GL_TRIANGLES, 3 * _triangle_count, GL_UNSIGNED_INT, 0);
+
+    RenderCounters& counters = RenderStats::live();
+    ++counters.draw_calls;
+    counters.triangles += _triangle_count;
+    counters.vertices += _vertex_count;
 }
 
 void Mesh::bind() const {
     finalize();
     glBindVertexArray(vao);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_triangles);
+    ++RenderStats::live().vao_binds;
 }
 
 void Mesh::unbind() const {
@@ -77,6 +85,8 @@ void Mesh::finalize() const {
 }
 
 void Mesh::unfinalize() {
+    _bounds_valid = false;
+    ++_version;
     if (!_finalized) return;
     _finalized = false;
     destroy_buffers();
@@ -136,6 +146,30 @@ void Mesh::resize_block(size_t vertex_count, size_t triangle_count) {
     _vertex_count = vertex_count;
     _triangle_count = triangle_count;
     _finalized = false;
+    _bounds_valid = false;
+    ++_version;
+}
+
+void Mesh::bounds(vec3& min, vec3& max) const {
+    if (!_bounds_valid) {
+        _bounds_valid = true;
+        _bounds_min = _bounds_max = vec3(0.0f);
+
+        // Positions are the first attribute, and are at least three floats wide
+        if (_attributes.count() > 0 && _attributes[0].size >= sizeof(vec3) && _vertex_count > 0) {
+            size_t stride = _attributes[0].size;
+            const char* data = buffers[0].data;
+            _bounds_min = _bounds_max = *(const vec3*)data;
+            for (size_t i = 1; i < _vertex_count; ++i) {
+                const vec3& position = *(const vec3*)(data + i * stride);
+                _bounds_min = frame::min(_bounds_min, position);
+                _bounds_max = frame::max(_bounds_max, position);
+            }
+        }
+    }
+
+    min = _bounds_min;
+    max = _bounds_max;
 }
 
 void Mesh::append(const Mesh& other) {
@@ -174,6 +208,7 @@ void Mesh::create_buffers() const {
         glGenBuffers(1, &buffers[i].vbo);
         glBindBuffer(GL_ARRAY_BUFFER, buffers[i].vbo);
         glBufferData(GL_ARRAY_BUFFER, buffers[i].size, buffers[i].data, _attributes[i].dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        RenderStats::live().buffer_bytes += buffers[i].size;
         glEnableVertexAttribArray(i);
         glVertexAttribPointer(i, _attributes[i].size / sizeof(float), GL_FLOAT, GL_FALSE, 0, 0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -183,6 +218,7 @@ void Mesh::create_buffers() const {
     glGenBuffers(1, &vbo_triangles);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_triangles);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(ivec3) * _triangle_count, _triangles, _dynamic_triangles ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    RenderStats::live().buffer_bytes += sizeof(ivec3) * _triangle_count;
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     // Unbind the vao
@@ -195,11 +231,14 @@ void Mesh::update_vertex_buffers() { update_vertex_buffers(0, _vertex_count); }
 void Mesh::update_vertex_buffers(size_t i) { update_vertex_buffers(i, i+1); }
 
 void Mesh::update_vertex_buffers(size_t i0, size_t i1) {
+    _bounds_valid = false;
+    ++_version;
     glBindVertexArray(vao);
     for (size_t i = 0; i < _attributes.count(); ++i) {
         size_t size = (i1 - i0) * _attributes[i].size;
         glBindBuffer(GL_ARRAY_BUFFER, buffers[i].vbo);
         glBufferSubData(GL_ARRAY_BUFFER, i0 * _attributes[i].size, size, buffers[i].data);
+        RenderStats::live().buffer_bytes += size;
     }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
@@ -207,10 +246,13 @@ void Mesh::update_vertex_buffers(size_t i0, size_t i1) {
 }
 
 void Mesh::update_vertex_buffer(size_t i, size_t i0, size_t i1) {
+    _bounds_valid = false;
+    ++_version;
     size_t size = (i1 - i0) * _attributes[i].size;
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, buffers[i].vbo);
     glBufferSubData(GL_ARRAY_BUFFER, i0 * _attributes[i].size, size, buffers[i].data);
+    RenderStats::live().buffer_bytes += size;
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     gl_check();
@@ -221,10 +263,12 @@ void Mesh::update_index_buffer() { update_index_buffer(0, _triangle_count); }
 void Mesh::update_index_buffer(size_t i) { update_index_buffer(i, i+1); }
 
 void Mesh::update_index_buffer(size_t i0, size_t i1) {
+    ++_version;
     size_t size = (i1 - i0) * sizeof(ivec3);
     glBindVertexArray(vao);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_triangles);
     glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, i0 * sizeof(ivec3), size, _triangles);
+    RenderStats::live().buffer_bytes += size;
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     gl_check();
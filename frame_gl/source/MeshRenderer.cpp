@@ -0,0 +1,28 @@
+#include "frame/Frame.h"
+#include "frame_gl/components/MeshRenderer.h"
+#include "frame_gl/systems/Render.h"
+using namespace frame;
+
+void MeshRenderer::setup(FrameInterface& frame, Entity* entity) {
+    if (Render* render = frame->systems().get<Render>())
+        render->add_renderer(this);
+}
+
+void MeshRenderer::teardown(FrameInterface& frame, Entity* entity) {
+    if (_render)
+        _render->remove_renderer(this);
+}
+
+MeshRenderer* MeshRenderer::set_layer(unsigned int layer) {
+
+    // Move to the new layer's bucket
+    if (_render) {
+        Render* render = _render;
+        render->remove_renderer(this);
+        _layer = layer;
+        render->add_renderer(this);
+    } else {
+        _layer = layer;
+    }
+    return this;
+}
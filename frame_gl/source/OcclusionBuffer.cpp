@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "frame_gl/data/OcclusionBuffer.h"
+using namespace frame;
+
+namespace
+{
+    // Clip space w below which a vertex is treated as crossing the camera plane
+    const float MIN_W = 1e-5f;
+}
+
+OcclusionBuffer::OcclusionBuffer(const ivec2& size, int tile_size)
+    : _size(size), tile_size(tile_size), generation(0) {
+
+    tiles = ivec2((size.x + tile_size - 1) / tile_size, (size.y + tile_size - 1) / tile_size);
+    bins.resize(tiles.x * tiles.y);
+
+    // Allocate each level of the pyramid, halving (and rounding up) until we reach a single texel
+    ivec2 level_size = size;
+    while (true) {
+        level_sizes.push_back(level_size);
+        pyramid.push_back(std::vector<float>(level_size.x * level_size.y, 1.0f));
+        if (level_size.x == 1 && level_size.y == 1) break;
+        level_size = ivec2(std::max(1, (level_size.x + 1) / 2), std::max(1, (level_size.y + 1) / 2));
+    }
+}
+
+void OcclusionBuffer::begin(const mat4& view_projection) {
+    this->view_projection = view_projection;
+    triangles.clear();
+    for (auto& bin : bins) bin.clear();
+    std::fill(pyramid[0].begin(), pyramid[0].end(), 1.0f);
+}
+
+void OcclusionBuffer::add_occluder(const Mesh& mesh, const mat4& model) {
+    const VertexAttributeSet& attributes = mesh.attributes();
+    if (attributes.count() == 0 || attributes[0].size < sizeof(vec3))
+        return;
+
+    add_occluder(mesh.vertexes(0).data, attributes[0].size, mesh.vertex_count(), mesh.triangles(), mesh.triangle_count(), model);
+}
+
+void OcclusionBuffer::add_occluder(const char* positions, size_t stride, size_t vertex_count, const ivec3* mesh_triangles, size_t triangle_count, const mat4& model) {
+
+    // Transform all vertices to screen space once
+    mat4 transform = view_projection * model;
+    std::vector<vec4> screen(vertex_count);
+    for (size_t i = 0; i < vertex_count; ++i) {
+        vec4 clip = transform * vec4(*(const vec3*)(positions + i * stride), 1.0f);
+
+        // Keep w around so triangles crossing the camera plane can be rejected below
+        if (clip.w < MIN_W) {
+            screen[i] = vec4(0.0f, 0.0f, 0.0f, -1.0f);
+            continue;
+        }
+
+        vec3 ndc = vec3(clip) / clip.w;
+        screen[i] = vec4(
+            (ndc.x * 0.5f + 0.5f) * _size.x,
+            (ndc.y * 0.5f + 0.5f) * _size.y,
+            ndc.z * 0.5f + 0.5f,
+            1.0f);
+    }
+
+    // Bin each triangle into every tile its bounds overlap
+    for (size_t i = 0; i < triangle_count; ++i) {
+        const vec4& a = screen[mesh_triangles[i].x];
+        const vec4& b = screen[mesh_triangles[i].y];
+        const vec4& c = screen[mesh_triangles[i].z];
+
+        // Skipping an occluder is always safe, so don't bother clipping
+        if (a.w < 0.0f || b.w < 0.0f || c.w < 0.0f) continue;
+        if (a.z < 0.0f || b.z < 0.0f || c.z < 0.0f) continue;
+
+        // Skip degenerate triangles
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (std::abs(area) < 1e-6f) continue;
+
+        // Find the pixel bounds, and skip anything entirely off screen
+        int x0 = std::max(0, (int)std::floor(std::min(a.x, std::min(b.x, c.x))));
+        int y0 = std::max(0, (int)std::floor(std::min(a.y, std::min(b.y, c.y))));
+        int x1 = std::min(_size.x - 1, (int)std::ceil(std::max(a.x, std::max(b.x, c.x))));
+        int y1 = std::min(_size.y - 1, (int)std::ceil(std::max(a.y, std::max(b.y, c.y))));
+        if (x0 > x1 || y0 > y1) continue;
+
+        // Store with counter-clockwise winding, so edge functions are positive inside
+        Triangle triangle = { vec3(a), vec3(b), vec3(c) };
+        if (area < 0.0f) std::swap(triangle.b, triangle.c);
+        uint32_t index = (uint32_t)triangles.size();
+        triangles.push_back(triangle);
+
+        for (int ty = y0 / tile_size; ty <= y1 / tile_size; ++ty)
+            for (int tx = x0 / tile_size; tx <= x1 / tile_size; ++tx)
+                bins[ty * tiles.x + tx].push_back(index);
+    }
+}
+
+unsigned int OcclusionBuffer::begin_rasterize() {
+    generation = work.open(bins.size());
+    return generation;
+}
+
+void OcclusionBuffer::rasterize(unsigned int generation) {
+    work.drain(generation, [this](size_t tile) { rasterize_tile(tile); });
+}
+
+void OcclusionBuffer::finish() {
+    rasterize(generation);
+    work.wait();
+    build_pyramid();
+}
+
+void OcclusionBuffer::rasterize_tile(size_t tile) {
+    const std::vector<uint32_t>& bin = bins[tile];
+    if (bin.empty()) return;
+
+    // Tile bounds in pixels
+    int tile_x0 = int(tile % tiles.x) * tile_size;
+    int tile_y0 = int(tile / tiles.x) * tile_size;
+    int tile_x1 = std::min(_size.x, tile_x0 + tile_size) - 1;
+    int tile_y1 = std::min(_size.y, tile_y0 + tile_size) - 1;
+
+    float* depth = pyramid[0].data();
+
+    for (uint32_t index : bin) {
+        const Triangle& t = triangles[index];
+
+        // Clamp the triangle bounds to this tile
+        int x0 = std::max(tile_x0, (int)std::floor(std::min(t.a.x, std::min(t.b.x, t.c.x))));
+        int y0 = std::max(tile_y0, (int)std::floor(std::min(t.a.y, std::min(t.b.y, t.c.y))));
+        int x1 = std::min(tile_x1, (int)std::ceil(std::max(t.a.x, std::max(t.b.x, t.c.x))));
+        int y1 = std::min(tile_y1, (int)std::ceil(std::max(t.a.y, std::max(t.b.y, t.c.y))));
+
+        // Edge function coefficients, e(x, y) = A * x + B * y + C
+        float a0 = t.a.y - t.b.y, b0 = t.b.x - t.a.x, c0 = t.a.x * t.b.y - t.a.y * t.b.x;
+        float a1 = t.b.y - t.c.y, b1 = t.c.x - t.b.x, c1 = t.b.x * t.c.y - t.b.y * t.c.x;
+        float a2 = t.c.y - t.a.y, b2 = t.a.x - t.c.x, c2 = t.c.x * t.a.y - t.c.y * t.a.x;
+
+        // Depth plane, pushed back by the largest change across half a pixel so that
+        // the stored depth is never nearer than the surface anywhere in the pixel.
+        float area = (t.b.x - t.a.x) * (t.c.y - t.a.y) - (t.b.y - t.a.y) * (t.c.x - t.a.x);
+        float dzdx = ((t.b.z - t.a.z) * (t.c.y - t.a.y) - (t.c.z - t.a.z) * (t.b.y - t.a.y)) / area;
+        float dzdy = ((t.c.z - t.a.z) * (t.b.x - t.a.x) - (t.b.z - t.a.z) * (t.c.x - t.a.x)) / area;
+        float z_bias = 0.5f * (std::abs(dzdx) + std::abs(dzdy));
+        float z_max = std::max(t.a.z, std::max(t.b.z, t.c.z));
+
+        for (int y = y0; y <= y1; ++y) {
+            float py = float(y) + 0.5f;
+            float* row = depth + y * _size.x;
+
+            // Straight-line and branch-free, so the compiler can vectorize it
+            for (int x = x0; x <= x1; ++x) {
+                float px = float(x) + 0.5f;
+                float e0 = a0 * px + b0 * py + c0;
+                float e1 = a1 * px + b1 * py + c1;
+                float e2 = a2 * px + b2 * py + c2;
+                float z = std::min(z_max, t.a.z + dzdx * (px - t.a.x) + dzdy * (py - t.a.y) + z_bias);
+                bool inside = e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f;
+                row[x] = (inside && z < row[x]) ? z : row[x];
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::build_pyramid() {
+
+    // Each texel of a level holds the farthest depth of the (up to) four beneath it
+    for (size_t level = 1; level < pyramid.size(); ++level) {
+        const std::vector<float>& source = pyramid[level - 1];
+        const ivec2& source_size = level_sizes[level - 1];
+        std::vector<float>& target = pyramid[level];
+        const ivec2& target_size = level_sizes[level];
+
+        for (int y = 0; y < target_size.y; ++y) {
+            int sy0 = y * 2, sy1 = std::min(y * 2 + 1, source_size.y - 1);
+            for (int x = 0; x < target_size.x; ++x) {
+                int sx0 = x * 2, sx1 = std::min(x * 2 + 1, source_size.x - 1);
+                target[y * target_size.x + x] = std::max(
+                    std::max(source[sy0 * source_size.x + sx0], source[sy0 * source_size.x + sx1]),
+                    std::max(source[sy1 * source_size.x + sx0], source[sy1 * source_size.x + sx1]));
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::visible(const vec3& min, const vec3& max, const mat4& model) const {
+    mat4 transform = view_projection * model;
+
+    // Find the screen rectangle and nearest depth of the box
+    vec2 rect_min(std::numeric_limits<float>::max());
+    vec2 rect_max(-std::numeric_limits<float>::max());
+    float z_min = std::numeric_limits<float>::max();
+    float z_max = -std::numeric_limits<float>::max();
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+        vec4 clip = transform * vec4(corner, 1.0f);
+
+        // Boxes crossing the camera plane can't be tested
+        if (clip.w < MIN_W) return true;
+
+        vec3 ndc = vec3(clip) / clip.w;
+        vec2 screen((ndc.x * 0.5f + 0.5f) * _size.x, (ndc.y * 0.5f + 0.5f) * _size.y);
+        rect_min = frame::min(rect_min, screen);
+        rect_max = frame::max(rect_max, screen);
+        z_min = std::min(z_min, ndc.z * 0.5f + 0.5f);
+        z_max = std::max(z_max, ndc.z * 0.5f + 0.5f);
+    }
+
+    // Entirely outside the view volume
+    if (rect_max.x < 0.0f || rect_max.y < 0.0f || rect_min.x > _size.x || rect_min.y > _size.y)
+        return false;
+    if (z_max < 0.0f || z_min > 1.0f)
+        return false;
+
+    // Crossing the near plane
+    if (z_min < 0.0f)
+        return true;
+
+    // Pick the finest level at which the rectangle covers no more than a few texels
+    int x0 = std::max(0, (int)std::floor(rect_min.x));
+    int y0 = std::max(0, (int)std::floor(rect_min.y));
+    int x1 = std::min(_size.x - 1, (int)std::floor(rect_max.x));
+    int y1 = std::min(_size.y - 1, (int)std::floor(rect_max.y));
+    int extent = std::max(x1 - x0, y1 - y0) + 1;
+    size_t level = 0;
+    while ((extent >> level) > 2 && level + 1 < pyramid.size())
+        ++level;
+
+    // Visible if the box is nearer than the farthest occluder depth in any covered texel
+    const std::vector<float>& depths = pyramid[level];
+    const ivec2& level_size = level_sizes[level];
+    for (int y = y0 >> level; y <= (y1 >> level); ++y)
+        for (int x = x0 >> level; x <= (x1 >> level); ++x)
+            if (z_min < depths[y * level_size.x + x])
+                return true;
+
+    return false;
+}
@@ -2,6 +2,7 @@
 #include "frame_gl/components/MeshRenderer.h"
 #include "frame_gl/data/Shader.h"
 #include "frame_gl/data/Texture.h"
+#include "frame_gl/data/UniformBuffer.h"
 #include "frame_gl/math.h"
 #include "frame_gl/systems/Planes.h"
 using namespace frame;
@@ -11,15 +12,14 @@ void Planes::setup() {
     auto plane_shader = Resource<Shader>(
         "Plane Shader",
 
-        Resource<ShaderPart>(ShaderPart::Type::Vertex,
+        Resource<ShaderPart>(ShaderPart::Type::Vertex, std::vector<std::string>({
             "#version 330\n                                                 "
             "layout(location = 0)in vec3 vert_position;                     "
             "layout(location = 1)in vec3 vert_normal;                       "
             "layout(location = 2)in vec2 vert_uv;                           "
-            "layout(location = 3)in vec4 vert_color;                        "
-            "uniform mat4 model;                                            "
-            "uniform mat4 view;                                             "
-            "uniform mat4 projection;                                       "
+            "layout(location = 3)in vec4 vert_color;                        ",
+            CameraBlock::glsl(),
+            ObjectBlock::glsl(),
             "out vec4 frag_position;                                        "
             "out vec4 frag_position_world;                                  "
             "out vec3 frag_normal;                                          "
@@ -28,14 +28,14 @@ void Planes::setup() {
             "out float frag_depth;                                          "
             "void main() {                                                  "
             "   frag_position_world = model * vec4(10000 * vert_position, 1.0); "
-            "   frag_position   = projection * view * frag_position_world;  "
+            "   frag_position   = view_projection * frag_position_world;    "
             "   frag_normal     = vert_normal * inverse(mat3(model));       "
             "   frag_uv         = vert_uv;                                  "
             "   frag_color      = vert_color;                               "
             "   frag_depth      = frag_position.z / (2000.0);               "
             "   gl_Position     = frag_position;                            "
             "}                                                              "
-        ),
+        })),
 
         Resource<ShaderPart>(ShaderPart::Type::Fragment,
             "#version 330\n                             "
@@ -1,38 +1,110 @@
 #define GLEW_STATIC
 #include <string>
+#include <thread>
+#include <tuple>
+#include <algorithm>
+#include <functional>
 #include <GL/glew.h>
 #include "frame/Log.h"
 #include "frame/Frame.h"
 #include "frame_gl/systems/Render.h"
+#include "frame_gl/data/GpuProfiler.h"
+#include "frame_gl/error.h"
 using namespace frame;
 
+namespace
+{
+    // Fewest renderers worth handing to a record task of their own
+    const size_t MIN_SLICE_SIZE = 256;
+
+    void hash_combine(size_t& seed, size_t value) {
+        seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+
+    bool indirect_supported() {
+        return GLEW_ARB_multi_draw_indirect && GLEW_ARB_shader_draw_parameters && GLEW_ARB_shader_storage_buffer_object;
+    }
+
+    // Objects are batched by everything that needs a state change between draws
+    typedef std::tuple< unsigned int, const Mesh*, unsigned int, int, bool > BatchKey;
+
+    BatchKey batch_key(const RenderPacket& packet) {
+        return BatchKey(packet.shader->id(), packet.mesh.operator->(), packet.texture->id(), packet.poly_mode, packet.cull_back);
+    }
+}
+
+void Render::setup() {
+
+    // Pick up any renderers which were set up before we were
+    for (auto object : node<MeshRenderer>())
+        if (!object->_render)
+            add_renderer(object);
+
+    // The shaders passes draw with are made here, so passes never have to make them on the render thread
+    standard_vertex = Shader::Preset::vert_standard();
+    placeholder_shader = Shader::Preset::placeholder();
+    depth_shader = Shader::Preset::depth_only();
+
+    camera_buffer = new UniformBuffer(sizeof(CameraBlock));
+    object_ring = new UniformRing(1024 * 256);
+    glGenBuffers(1, &indirect_buffer);
+    glGenBuffers(1, &draw_data_buffer);
+}
+
+void Render::teardown() {
+    if (_render_thread)
+        _render_thread->wait();
+
+    for (auto& bucket : layer_buckets) {
+        for (MeshRenderer* object : bucket)
+            object->_render = nullptr;
+        bucket.clear();
+    }
+
+    transient_targets.clear();
+    delete camera_buffer;
+    delete object_ring;
+    glDeleteBuffers(1, &indirect_buffer);
+    glDeleteBuffers(1, &draw_data_buffer);
+}
+
 void Render::step() {
+    _time += float(dt());
 
-    // For each camera, render all meshes
-    for (auto entity : node<Camera, RenderTarget>()) {
+    // Everything below touches GL, or data the last frame's passes may still be reading
+    if (_render_thread)
+        _render_thread->wait();
 
-        // Render all meshes on this camera
-        auto camera = entity.get<Camera>();
-        auto target = entity.get<RenderTarget>();
-        target->bind_target(auto_clear);
+    // Run anything left over from a frame which was never shown
+    if (!_graph.empty())
+        execute_graph();
 
+    object_ring->next_frame();
+    transient_targets.next_frame();
 
-        // Draw all the meshes in their own modes
-        for (auto object : node<MeshRenderer>()) {
-            if (camera->has_layer(object->layer())) {
-                object->bind(camera);
+    // Resolution changes can only land once nothing is reading the targets' viewports
+    for (auto target : node<RenderTarget>())
+        target->apply_render_scale();
 
-                // Should find a better way to do this...
-                if (_mode == Wireframe)
-                    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    // Start counting this frame's work from scratch
+    RenderCounters& live = RenderStats::live();
+    live.reset();
+    frame_stats.cameras.clear();
+    frame_stats.layers.assign(MAX_LAYERS, RenderCounters());
+    size_t drawn = 0;
 
-                object->render(camera);
-                object->unbind();
-            }
-        } 
+    // Fall back to immediate submission if the driver can't do indirect
+    if (_submission == Indirect && !indirect_supported()) {
+        Log::warning("Multi-draw-indirect is not supported, falling back to immediate submission");
+        _submission = Immediate;
+    }
 
-        // Unbind the render target
-        target->unbind_target();
+    // For each camera, render all meshes
+    for (auto entity : node<Camera, RenderTarget>()) {
+
+        // Render all meshes on this camera
+        auto camera = entity.get<Camera>();
+        auto target = entity.get<RenderTarget>();
 
         // Update the display camera for this layer
         int layer = target->display_layer();
@@ -41,6 +113,105 @@ void Render::step() {
             display_cameras[layer] = camera;
         }
 
+        // Gather the renderers from the buckets of this camera's layers, so record tasks can split
+        // them into slices. Parent transforms are shared between renderers, so they're resolved
+        // here where only one thread can touch them.
+        renderers.clear();
+        unsigned int layer_mask = camera->layer_mask();
+        for (unsigned int layer = 0; layer < MAX_LAYERS; ++layer) {
+            if ((layer_mask & (1u << layer)) == 0)
+                continue;
+            for (MeshRenderer* object : layer_buckets[layer]) {
+                renderers.push_back(object);
+                if (auto parent = object->get<Transform>()->parent())
+                    parent->world_matrix();
+            }
+        }
+
+        RenderStats::CameraStats camera_stats = { layer_mask, false, RenderCounters() };
+
+        // Leave the target's previous contents alone if its policy says not to redraw. Targets
+        // which are always redrawn don't need a signature.
+        bool always = target->redraw() == RenderTarget::Always;
+        if (!target->should_redraw(always ? 0 : signature(camera, target))) {
+            camera_stats.skipped = true;
+            frame_stats.cameras.push_back(camera_stats);
+            continue;
+        }
+
+        if (camera_passes.size() <= drawn)
+            camera_passes.resize(drawn + 1);
+        CameraPass& pass = camera_passes[drawn];
+        pass.name = "Render camera " + std::to_string(frame_stats.cameras.size());
+        pass.camera = camera_block(camera);
+        pass.stats_index = frame_stats.cameras.size();
+
+        // Find out which objects are hidden behind occluders
+        if (_occlusion_culling)
+            cull_occluded(camera, visible);
+
+        // Use one slice per thread, so long as they're big enough to be worth it
+        size_t slices = std::max<size_t>(1, std::min<size_t>(
+            std::max(1u, std::thread::hardware_concurrency()),
+            renderers.size() / MIN_SLICE_SIZE));
+        packet_lists.resize(slices);
+
+        // Record packets for the meshes this camera can see, with help from worker threads
+        record_view = camera->view_matrix();
+        unsigned int generation = record_work.open(slices);
+        for (size_t i = 1; i < slices; ++i)
+            enqueue<RecordPackets>(this, generation);
+        record(generation);
+        record_work.wait();
+
+        // Merge the lists in slice order, splitting off blended objects
+        std::vector<RenderPacket>& packets = pass.packets;
+        std::vector<RenderPacket>& blended_packets = pass.blended_packets;
+        packets.clear();
+        blended_packets.clear();
+        for (auto& list : packet_lists) {
+            for (auto& packet : list) {
+                packet.mesh = packet.renderer->_mesh;
+                packet.texture = packet.renderer->_texture;
+                packet.shader = packet.renderer->_shader;
+                (packet.blend_mode != MeshRenderer::Opaque ? blended_packets : packets).push_back(packet);
+            }
+            list.clear();
+        }
+
+        // Opaque objects go front to back, so early depth testing rejects as many fragments as
+        // possible, and blended objects go back to front, so they composite correctly
+        std::stable_sort(packets.begin(), packets.end(), [](const RenderPacket& a, const RenderPacket& b) { return a.depth < b.depth; });
+        std::stable_sort(blended_packets.begin(), blended_packets.end(), [](const RenderPacket& a, const RenderPacket& b) { return a.depth > b.depth; });
+
+        // Pull out the opaque objects which can be drawn indirectly
+        std::vector<RenderPacket>& batched_packets = pass.batched_packets;
+        batched_packets.clear();
+        if (_submission == Indirect)
+            batch_packets(packets, batched_packets);
+
+        // Upload the constants of every object at once
+        pass.offsets.clear();
+        pass.batched_offsets.clear();
+        pass.blended_offsets.clear();
+        for (auto& packet : packets)
+            pass.offsets.push_back(object_ring->push(packet.constants));
+        for (auto& packet : batched_packets)
+            pass.batched_offsets.push_back(object_ring->push(packet.constants));
+        for (auto& packet : blended_packets)
+            pass.blended_offsets.push_back(object_ring->push(packet.constants));
+        flush_objects();
+
+        count_layers(packets);
+        count_layers(batched_packets);
+        count_layers(blended_packets);
+        camera_stats.counters.objects_culled = count_culled();
+        frame_stats.cameras.push_back(camera_stats);
+
+        // Drawing waits until the graph runs, by which point other systems have declared their passes on the same target
+        _graph.add_pass(pass.name, _graph.import(target->frame_buffer()), {}, [this, drawn]() { render_camera(drawn); }, auto_clear);
+        ++drawn;
+
         // If we haven't yet found a display target, look for one along with it's camera.
         /*
         if (!_display_target) {
@@ -53,8 +224,9 @@ void Render::step() {
         */
     }
 
-    // Update display targets
+    // Update display targets, and hand over any pixels which have been read back
     for (auto target : node<RenderTarget>()) {
+        target->poll_reads();
         int layer = target->display_layer();
         if (layer != -1)
             display_targets[layer] = target;
@@ -74,10 +246,373 @@ void Render::step() {
     */
 }
 
+void Render::render_camera(size_t index) {
+    CameraPass& pass = camera_passes[index];
+    RenderCounters& live = RenderStats::live();
+    RenderCounters before = live;
+    GpuProfiler::get().begin(pass.name);
+
+    bind_camera(pass.camera);
+
+    // Lay down the depth of opaque objects first, if asked to
+    if (_depth_prepass && _mode == Normal) {
+        render_depth(pass.packets, pass.offsets);
+        render_depth(pass.batched_packets, pass.batched_offsets);
+    }
+
+    // Draw all the opaque meshes in their own modes, batching whatever can be
+    render_immediate(pass.camera, pass.packets, pass.offsets);
+    if (!pass.batched_packets.empty())
+        render_indirect(pass.batched_packets);
+
+    // Blended meshes are tested against depth, but don't write it
+    if (!pass.blended_packets.empty()) {
+        glDepthMask(GL_FALSE);
+        render_immediate(pass.camera, pass.blended_packets, pass.blended_offsets);
+        glDepthMask(GL_TRUE);
+    }
+    glDepthFunc(GL_LESS);
+
+    // Added to the culls counted when the camera was recorded
+    GpuProfiler::get().end(pass.name);
+    frame_stats.cameras[pass.stats_index].counters += live - before;
+}
+
+void Render::execute_graph() {
+    _graph.execute(transient_targets);
+
+    // The frame's work is all done now
+    frame_stats.total = RenderStats::live();
+    _stats = frame_stats;
+}
+
+CameraBlock Render::camera_block(Camera* camera) const {
+    CameraBlock block;
+    block.view = camera->view_matrix();
+    block.projection = camera->projection_matrix();
+    block.view_projection = block.projection * block.view;
+    block.inverse_view = inverse(block.view);
+    block.inverse_projection = inverse(block.projection);
+    block.screen_size = vec2(camera->target()->size());
+    block.time = _time;
+    block.padding = 0.0f;
+    return block;
+}
+
+void Render::bind_camera(const CameraBlock& block) {
+    camera_buffer->write(&block, sizeof(CameraBlock));
+    camera_buffer->bind(CameraBlock::Binding);
+}
+
+size_t Render::push_object(const mat4& model, const vec4& color, const vec4& params) {
+    ObjectBlock block;
+    block.model = model;
+    block.color = color;
+    block.params = params;
+    return object_ring->push(block);
+}
+
+void Render::add_renderer(MeshRenderer* renderer) {
+    if (renderer->layer() >= MAX_LAYERS) {
+        Log::error("Mesh renderer layer " + std::to_string(renderer->layer()) + " is out of range");
+        return;
+    }
+
+    auto& bucket = layer_buckets[renderer->layer()];
+    renderer->_render = this;
+    renderer->_bucket_index = bucket.size();
+    bucket.push_back(renderer);
+}
+
+void Render::remove_renderer(MeshRenderer* renderer) {
+    if (renderer->_render != this)
+        return;
+
+    // Swap the last renderer of the bucket into this one's place
+    auto& bucket = layer_buckets[renderer->layer()];
+    MeshRenderer* last = bucket.back();
+    bucket[renderer->_bucket_index] = last;
+    last->_bucket_index = renderer->_bucket_index;
+    bucket.pop_back();
+    renderer->_render = nullptr;
+}
+
+size_t Render::signature(Camera* camera, RenderTarget* target) {
+
+    // Everything about the camera and the way it's drawn
+    size_t seed = 0;
+    hash_combine(seed, camera->version());
+    hash_combine(seed, camera->get<Transform>()->version());
+    hash_combine(seed, size_t(target->size().x));
+    hash_combine(seed, size_t(target->size().y));
+    hash_combine(seed, size_t(_mode));
+    hash_combine(seed, size_t(_occlusion_culling));
+
+    // Everything about each renderer it can see. Hashing the pointers picks up renderers being added and removed.
+    for (MeshRenderer* object : renderers) {
+        hash_combine(seed, std::hash<const void*>()(object));
+        hash_combine(seed, size_t(object->layer()));
+        hash_combine(seed, object->get<Transform>()->version());
+        hash_combine(seed, std::hash<const void*>()(object->mesh().operator->()));
+        hash_combine(seed, object->mesh()->version());
+        hash_combine(seed, object->shader()->id());
+        hash_combine(seed, object->texture()->id());
+        hash_combine(seed, size_t(object->blend_mode()));
+    }
+
+    return seed;
+}
+
+void Render::record(unsigned int generation) {
+    record_work.drain(generation, [this](size_t slice) { record_slice(slice); });
+}
+
+void RecordPackets::run() {
+    render->record(generation);
+}
+
+void Render::record_slice(size_t slice) {
+    std::vector<RenderPacket>& list = packet_lists[slice];
+    list.clear();
+
+    size_t begin = slice * renderers.size() / packet_lists.size();
+    size_t end = (slice + 1) * renderers.size() / packet_lists.size();
+    for (size_t i = begin; i < end; ++i) {
+        MeshRenderer* object = renderers[i];
+        if (_occlusion_culling && !visible[i])
+            continue;
+
+        // Copying resources would change their reference counts from several threads at once,
+        // so they're picked up from the renderer when the slices are merged
+        RenderPacket packet;
+        packet.renderer = object;
+        packet.poly_mode = object->_poly_mode;
+        packet.blend_mode = object->_blend_mode;
+        packet.cull_back = object->_cull_back;
+        packet.layer = object->_layer;
+        packet.constants.model = object->get<Transform>()->world_matrix();
+        packet.constants.color = vec4(1.0f);
+        packet.constants.params = vec4(0.0f);
+
+        // Sort by the distance of the object's origin in front of the camera
+        packet.depth = -(record_view * packet.constants.model[3]).z;
+        list.push_back(packet);
+    }
+}
+
+void Render::render_immediate(const CameraBlock& camera, const std::vector<RenderPacket>& packets, const std::vector<size_t>& offsets) {
+    for (size_t i = 0; i < packets.size(); ++i) {
+        const RenderPacket& packet = packets[i];
+        bind_object(offsets[i]);
+        MeshRenderer::bind_state(_mode == Wireframe ? MeshRenderer::Line : packet.poly_mode, packet.cull_back, packet.blend_mode);
+        packet.texture->bind(0);
+
+        // Shaders still compiling are stood in for, rather than stalling the frame
+        const Shader* shader = packet.shader->ready() ? packet.shader.operator->() : placeholder_shader.operator->();
+        shader->bind();
+
+        // Shaders which still declare loose matrix uniforms get them here
+        const ShaderUniformLocations& uniforms = shader->uniforms();
+        if (uniforms.model != -1)
+            shader->uniform(ShaderUniform::Model, packet.constants.model);
+        if (uniforms.view != -1)
+            shader->uniform(ShaderUniform::View, camera.view);
+        if (uniforms.projection != -1)
+            shader->uniform(ShaderUniform::Projection, camera.projection);
+
+        packet.mesh->render();
+
+        shader->unbind();
+        packet.texture->unbind();
+        MeshRenderer::unbind_state(packet.blend_mode);
+    }
+}
+
+void Render::batch_packets(std::vector<RenderPacket>& packets, std::vector<RenderPacket>& batched) {
+
+    // Pull out everything which can be drawn indirectly, leaving the rest to be drawn one by
+    // one. That includes objects whose indirect shader is still compiling, until it's ready.
+    size_t kept = 0;
+    for (size_t i = 0; i < packets.size(); ++i) {
+        if (packets[i].shader->uses(standard_vertex) && indirect_shader(packets[i].shader)->ready())
+            batched.push_back(packets[i]);
+        else
+            packets[kept++] = packets[i];
+    }
+    packets.resize(kept);
+
+    // Stable, so objects keep their front to back order within each batch
+    std::stable_sort(batched.begin(), batched.end(), [](const RenderPacket& a, const RenderPacket& b) {
+        return batch_key(a) < batch_key(b);
+    });
+}
+
+void Render::render_indirect(const std::vector<RenderPacket>& packets) {
+
+    // One command and one model matrix per object. The base instance
+    // is how the vertex shader finds its model matrix.
+    indirect_commands.clear();
+    draw_data.clear();
+    for (const RenderPacket& packet : packets) {
+        DrawIndirectCommand command = { 3 * (unsigned int)packet.mesh->triangle_count(), 1, 0, 0, (unsigned int)draw_data.size() };
+        indirect_commands.push_back(command);
+        draw_data.push_back(packet.constants.model);
+    }
+
+    // Upload all commands and per-draw data at once
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, indirect_commands.size() * sizeof(DrawIndirectCommand), indirect_commands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, draw_data_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, draw_data.size() * sizeof(mat4), draw_data.data(), GL_STREAM_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, draw_data_buffer);
+    RenderStats::live().buffer_bytes += indirect_commands.size() * sizeof(DrawIndirectCommand) + draw_data.size() * sizeof(mat4);
+
+    // Issue one multi-draw per batch
+    size_t first = 0;
+    while (first < packets.size()) {
+        const RenderPacket& packet = packets[first];
+        BatchKey key = batch_key(packet);
+        size_t last = first + 1;
+        while (last < packets.size() && batch_key(packets[last]) == key)
+            ++last;
+
+        glPolygonMode(GL_FRONT_AND_BACK, _mode == Wireframe ? GL_LINE : packet.poly_mode);
+        if (packet.cull_back) glEnable(GL_CULL_FACE);
+        else glDisable(GL_CULL_FACE);
+
+        // Every batched packet's indirect shader was made and found ready when it was batched
+        const Shader* shader = indirect_shaders.find(packet.shader.operator->())->second.second.operator->();
+        packet.texture->bind(0);
+        shader->bind();
+
+        packet.mesh->bind();
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)(first * sizeof(DrawIndirectCommand)), GLsizei(last - first), 0);
+        packet.mesh->unbind();
+
+        RenderCounters& counters = RenderStats::live();
+        ++counters.draw_calls;
+        counters.triangles += (last - first) * packet.mesh->triangle_count();
+        counters.vertices += (last - first) * packet.mesh->vertex_count();
+
+        shader->unbind();
+        packet.texture->unbind();
+        first = last;
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    gl_check();
+}
+
+void Render::render_depth(const std::vector<RenderPacket>& packets, const std::vector<size_t>& offsets) {
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    depth_shader->bind();
+
+    for (size_t i = 0; i < packets.size(); ++i) {
+        const RenderPacket& packet = packets[i];
+
+        // Only shaders built on vert_standard are sure to write exactly the same depth
+        if (packet.poly_mode != MeshRenderer::Fill || !packet.shader->uses(standard_vertex))
+            continue;
+
+        if (packet.cull_back) glEnable(GL_CULL_FACE);
+        else glDisable(GL_CULL_FACE);
+
+        bind_object(offsets[i]);
+        packet.mesh->render();
+    }
+
+    depth_shader->unbind();
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    // The shading pass arrives at the same depths, which have to pass
+    glDepthFunc(GL_LEQUAL);
+    gl_check();
+}
+
+Resource<Shader> Render::indirect_shader(const Resource<Shader>& shader) {
+
+    // The cache holds on to each source shader, so its address can't be reused by another
+    // shader while the entry is alive, the way GL reuses program names
+    auto it = indirect_shaders.find(shader.operator->());
+    if (it != indirect_shaders.end())
+        return it->second.second;
+
+    // Swap the vertex stage for the one which reads per-draw data
+    std::vector< Resource<ShaderPart> > parts = { Shader::Preset::vert_indirect() };
+    for (auto& part : shader->parts())
+        if (part->type() != ShaderPart::Type::Vertex)
+            parts.push_back(part);
+
+    Resource<Shader> indirect(shader->name() + " (Indirect)", parts);
+    indirect_shaders.insert(std::make_pair(shader.operator->(), std::make_pair(shader, indirect)));
+    return indirect;
+}
+
+void Render::count_layers(const std::vector<RenderPacket>& packets) {
+
+    // Everything drawn, by the layer of its renderer
+    for (const RenderPacket& packet : packets) {
+        RenderCounters& counters = frame_stats.layers[packet.layer];
+        const Mesh* mesh = packet.mesh.operator->();
+        ++counters.draw_calls;
+        counters.triangles += mesh->triangle_count();
+        counters.vertices += mesh->vertex_count();
+    }
+}
+
+size_t Render::count_culled() {
+
+    // Everything the occlusion buffer hid from the current camera, by layer and in total
+    size_t culled = 0;
+    if (!_occlusion_culling)
+        return culled;
+    for (size_t i = 0; i < renderers.size(); ++i) {
+        if (!visible[i]) {
+            ++frame_stats.layers[renderers[i]->layer()].objects_culled;
+            ++culled;
+        }
+    }
+    RenderStats::live().objects_culled += culled;
+    return culled;
+}
+
+void Render::cull_occluded(Camera* camera, std::vector<bool>& visible) {
+
+    // Bin the triangles of every occluder this camera can see
+    occlusion.begin(camera->projection_matrix() * camera->view_matrix());
+    for (MeshRenderer* object : renderers)
+        if (object->occluder())
+            occlusion.add_occluder(*object->mesh(), object->get<Transform>()->world_matrix());
+
+    visible.assign(renderers.size(), true);
+    if (occlusion.occluder_triangles() == 0)
+        return;
+
+    // Share the tiles out with worker threads, and help rasterize them until they're all done
+    unsigned int generation = occlusion.begin_rasterize();
+    unsigned int helpers = std::thread::hardware_concurrency();
+    for (unsigned int i = 1; i < helpers && i < occlusion.tile_count(); ++i)
+        enqueue<RasterizeOcclusion>(&occlusion, generation);
+    occlusion.finish();
+
+    // Test the bounds of everything else against the depth pyramid
+    vec3 min, max;
+    for (size_t i = 0; i < renderers.size(); ++i) {
+        MeshRenderer* object = renderers[i];
+        if (!object->occluder()) {
+            object->mesh()->bounds(min, max);
+            visible[i] = occlusion.visible(min, max, object->get<Transform>()->world_matrix());
+        }
+    }
+}
+
 void Render::load_prototypes(std::back_insert_iterator< std::vector< CommandPrototype > >& commands) {
     *(commands++) = {
-        Command("render", "[stats|wires]"),
-        "List statistics and toggle wireframe",
+        Command("render", "[stats|profile|wires|occlusion|indirect|prepass]"),
+        "List statistics and timings, toggle wireframe, occlusion culling, indirect submission and the depth prepass",
         ""
     };
 }
@@ -91,6 +626,29 @@ void Render::handle(Command command) {
     if (command.arg(0) == "stats") {
         command.add_result_line("Render targets: " + std::to_string(node<RenderTarget>().size()));
         command.add_result_line("Mesh Renderers: " + std::to_string(node<MeshRenderer>().size()));
+        command.add_result_line("Pooled frame buffers: " + std::to_string(transient_targets.allocated()) + " (" + std::to_string(transient_targets.in_use()) + " in use)");
+        command.add_result_line("Render graph: " + std::to_string(_graph.passes_run()) + " passes, " + std::to_string(_graph.passes_culled()) + " culled, " + std::to_string(_graph.target_binds()) + " target binds");
+        command.add_result_line("Total: " + _stats.total.summary());
+
+        for (size_t i = 0; i < _stats.cameras.size(); ++i) {
+            const RenderStats::CameraStats& camera = _stats.cameras[i];
+            command.add_result_line("Camera " + std::to_string(i) + ": " +
+                (camera.skipped ? std::string("skipped, unchanged") : camera.counters.summary()));
+        }
+
+        // Only list the layers which drew or culled anything
+        for (size_t i = 0; i < _stats.layers.size(); ++i) {
+            const RenderCounters& layer = _stats.layers[i];
+            if (layer.draw_calls > 0 || layer.objects_culled > 0)
+                command.add_result_line("Layer " + std::to_string(i) + ": draws " + std::to_string(layer.draw_calls) +
+                    ", tris " + std::to_string(layer.triangles) +
+                    ", verts " + std::to_string(layer.vertices) +
+                    ", culled " + std::to_string(layer.objects_culled));
+        }
+
+    } else if (command.arg(0) == "profile") {
+        for (auto& line : GpuProfiler::get().report())
+            command.add_result_line(line);
 
     } else if (command.arg(0) == "wires") {
         if (_mode == Normal) {
@@ -100,5 +658,17 @@ void Render::handle(Command command) {
             _mode = Normal;
             command.add_result_line("Wireframes Off");
         }
+
+    } else if (command.arg(0) == "occlusion") {
+        _occlusion_culling = !_occlusion_culling;
+        command.add_result_line(_occlusion_culling ? "Occlusion Culling On" : "Occlusion Culling Off");
+
+    } else if (command.arg(0) == "indirect") {
+        _submission = (_submission == Immediate) ? Indirect : Immediate;
+        command.add_result_line(_submission == Indirect ? "Indirect Submission On" : "Indirect Submission Off");
+
+    } else if (command.arg(0) == "prepass") {
+        _depth_prepass = !_depth_prepass;
+        command.add_result_line(_depth_prepass ? "Depth Prepass On" : "Depth Prepass Off");
     }
 }
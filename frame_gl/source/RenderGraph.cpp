@@ -0,0 +1,191 @@
+#include <string>
+#include "frame/Log.h"
+#include "frame_gl/data/RenderGraph.h"
+using namespace frame;
+
+namespace
+{
+    const size_t NONE = size_t(-1);
+}
+
+RenderGraph::RenderGraph() : _passes_run(0), _passes_culled(0), _target_binds(0), running(false) {
+    reset();
+}
+
+RenderGraph::Handle RenderGraph::import(FrameBuffer* buffer) {
+    auto it = imported.find(buffer);
+    if (it != imported.end())
+        return it->second;
+
+    TargetResource resource = { buffer, false, ivec2(0), Texture::RGBA8, false, FrameBuffer::Depth24, NONE, 0 };
+    resources.push_back(resource);
+    imported.insert(std::make_pair(buffer, resources.size() - 1));
+    return resources.size() - 1;
+}
+
+RenderGraph::Handle RenderGraph::create(const ivec2& size, Texture::Format format, bool depth, FrameBuffer::DepthFormat depth_format) {
+    TargetResource resource = { nullptr, true, size, format, depth, depth_format, NONE, 0 };
+    resources.push_back(resource);
+    return resources.size() - 1;
+}
+
+void RenderGraph::add_pass(const std::string& name, Handle target, const std::vector<Handle>& reads, const Execute& execute, bool clear) {
+    if (running) {
+        Log::warning("Render pass " + name + " was added while the render graph was running, and won't be run");
+        return;
+    }
+
+    Pass pass = { name, target, reads, execute, clear };
+    passes.push_back(pass);
+}
+
+bool RenderGraph::depends(const Pass& later, const Pass& earlier) const {
+
+    // Writes to the same target keep their order, since later ones draw over earlier ones
+    if (later.target == earlier.target)
+        return true;
+
+    // Reading what an earlier pass drew, or drawing over what an earlier pass still has to read
+    for (Handle read : later.reads)
+        if (read == earlier.target) return true;
+    for (Handle read : earlier.reads)
+        if (read == later.target) return true;
+
+    return false;
+}
+
+size_t RenderGraph::schedule(std::vector<size_t>& order) const {
+
+    // Walk back from the last pass, keeping passes whose target is read by something after them
+    std::vector<bool> needed(resources.size()), live(passes.size(), false);
+    for (size_t i = 0; i < resources.size(); ++i)
+        needed[i] = !resources[i].transient;
+
+    size_t live_count = 0, culled = 0;
+    for (size_t i = passes.size(); i-- > 0;) {
+        if (!needed[passes[i].target]) {
+            ++culled;
+            continue;
+        }
+
+        live[i] = true;
+        ++live_count;
+        for (Handle read : passes[i].reads)
+            needed[read] = true;
+    }
+
+    // Schedule passes in the order they were added, except that a ready pass on the target
+    // which is already bound jumps ahead, so it can share the bind
+    order.clear();
+    std::vector<bool> scheduled(passes.size(), false);
+    while (order.size() < live_count) {
+        size_t pick = NONE;
+        for (size_t i = 0; i < passes.size(); ++i) {
+            if (!live[i] || scheduled[i])
+                continue;
+
+            bool ready = true;
+            for (size_t j = 0; j < i && ready; ++j)
+                if (live[j] && !scheduled[j] && depends(passes[i], passes[j]))
+                    ready = false;
+            if (!ready)
+                continue;
+
+            if (pick == NONE)
+                pick = i;
+            if (!order.empty() && passes[i].target == passes[order.back()].target) {
+                pick = i;
+                break;
+            }
+        }
+
+        scheduled[pick] = true;
+        order.push_back(pick);
+    }
+
+    return culled;
+}
+
+std::vector<std::string> RenderGraph::plan() const {
+    std::vector<size_t> order;
+    schedule(order);
+
+    std::vector<std::string> names;
+    for (size_t i : order)
+        names.push_back(passes[i].name);
+    return names;
+}
+
+void RenderGraph::execute(FrameBufferPool& pool) {
+    _passes_run = _target_binds = 0;
+    running = true;
+
+    std::vector<size_t> order;
+    _passes_culled = schedule(order);
+
+    // Find where each transient target is first and last used
+    for (size_t k = 0; k < order.size(); ++k) {
+        const Pass& pass = passes[order[k]];
+        std::vector<Handle> used = pass.reads;
+        used.push_back(pass.target);
+        for (Handle handle : used) {
+            TargetResource& resource = resources[handle];
+            if (!resource.transient)
+                continue;
+            if (resource.first == NONE)
+                resource.first = k;
+            resource.last = k;
+        }
+    }
+
+    // Run them, only binding a frame buffer when the target changes
+    FrameBuffer* bound = nullptr;
+    for (size_t k = 0; k < order.size(); ++k) {
+        const Pass& pass = passes[order[k]];
+
+        // Transient targets come out of the pool just before their first pass
+        for (TargetResource& resource : resources)
+            if (resource.transient && resource.first == k)
+                resource.buffer = pool.acquire(resource.size, resource.format, resource.depth, resource.depth_format);
+
+        FrameBuffer* target = resources[pass.target].buffer;
+        if (target != bound) {
+            if (target) {
+                target->bind_target(pass.clear);
+                ++_target_binds;
+            } else {
+                bound->unbind_target();
+            }
+            bound = target;
+        } else if (target) {
+            target->reset_state(pass.clear);
+        }
+
+        pass.execute();
+        ++_passes_run;
+
+        // And go back right after their last
+        for (TargetResource& resource : resources) {
+            if (resource.transient && resource.buffer && resource.last == k) {
+                pool.release(resource.buffer);
+                resource.buffer = nullptr;
+            }
+        }
+    }
+
+    if (bound)
+        bound->unbind_target();
+
+    running = false;
+    reset();
+}
+
+void RenderGraph::reset() {
+    resources.clear();
+    imported.clear();
+    passes.clear();
+
+    // The screen is always the first handle
+    TargetResource screen = { nullptr, false, ivec2(0), Texture::RGBA8, false, FrameBuffer::Depth24, NONE, 0 };
+    resources.push_back(screen);
+}
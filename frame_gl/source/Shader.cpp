@@ -1,24 +1,72 @@
 #define GLEW_STATIC
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
 #include <string>
 #include <GL/glew.h>
 #include <glm/gtc/type_ptr.hpp>
 #include "frame/Log.h"
 #include "frame/Resource.h"
 #include "frame_gl/data/Shader.h"
+#include "frame_gl/data/UniformBuffer.h"
+#include "frame_gl/data/RenderStats.h"
 #include "frame_gl/error.h"
 using namespace frame;
 
-ShaderPart::ShaderPart(Type type, const std::vector<std::string>& sources) : type(type) {
+namespace
+{
+    const unsigned int CACHE_MAGIC = 0x46534243; // "FSBC"
+
+    std::string& cache_directory_setting() {
+        static std::string directory(std::getenv("FRAME_SHADER_CACHE") ? std::getenv("FRAME_SHADER_CACHE") : "");
+        return directory;
+    }
+
+    // FNV-1a, which is plenty to tell shaders apart
+    void hash_string(unsigned long long& hash, const std::string& data) {
+        for (unsigned char c : data) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        hash ^= 0xff;
+        hash *= 1099511628211ULL;
+    }
+
+    std::string gl_string(GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string((const char*)value) : std::string();
+    }
+}
+
+ShaderPart::ShaderPart(Type type, const std::vector<std::string>& sources) : _type(type), _sources(sources), _id(0), _compiled(false), _checked(false), _valid(false) {}
+
+void ShaderPart::compile() {
+    _compiled = true;
+
+    // Let the driver spread compiles over as many threads as it likes, before the first one
+    static bool parallel = false;
+    if (!parallel && GLEW_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    parallel = true;
 
     // Convert shader sources to GL strings... :(
     std::vector<GLchar*> gl_sources;
-    for (const std::string& source : sources)
+    for (const std::string& source : _sources)
         gl_sources.push_back((GLchar*)source.data());
 
-    // Create and compile the shader
-    _id = glCreateShader(type);
-    glShaderSource(_id, sources.size(), gl_sources.data(), 0);
+    // Create and compile the shader. Its status is only asked for once the program using it
+    // is needed, so the driver can get on with several compiles at once.
+    _id = glCreateShader(_type);
+    glShaderSource(_id, _sources.size(), gl_sources.data(), 0);
     glCompileShader(_id);
+}
+
+bool ShaderPart::check() {
+    if (!_compiled || _checked)
+        return !_compiled || _valid;
+    _checked = true;
 
     // Print an error message if the compilation failed
     int status;
@@ -30,67 +78,226 @@ ShaderPart::ShaderPart(Type type, const std::vector<std::string>& sources) : typ
         glGetShaderInfoLog(_id, length, 0, buffer);
         Log::error("Shader part failed to compile:\n" + std::string(buffer));
         delete[] buffer;
-        return;
+        return false;
     }
 
     // Success message
     Log::success("Shader part compiled successfully: " + std::to_string(_id));
+    _valid = true;
+    return true;
 }
 
-ShaderPart::~ShaderPart() { glDeleteShader(_id); }
+ShaderPart::~ShaderPart() { if (_compiled) glDeleteShader(_id); }
 
-Shader::Shader() : _name("empty"), _id(0) {}
+Shader::Shader() : _name("empty"), _id(0), _variant(0), _state(Linked), _cached(false), _uniforms({ -1, -1, -1, -1 }) {}
 Shader::Shader(const std::string& name, const Resource<ShaderPart>& pass1) : Shader(name, std::vector< Resource<ShaderPart> >({ pass1 })) {}
 Shader::Shader(const std::string& name, const Resource<ShaderPart>& pass1, const Resource<ShaderPart>& pass2) : Shader(name, std::vector< Resource<ShaderPart> >({ pass1, pass2 })) {}
 Shader::Shader(const std::string& name, const Resource<ShaderPart>& pass1, const Resource<ShaderPart>& pass2, const Resource<ShaderPart>& pass3) : Shader(name, std::vector< Resource<ShaderPart> >({ pass1, pass2, pass3 })) {}
-Shader::Shader(const std::string& name, const std::vector< Resource<ShaderPart> >& parts) : _name(name) {
+Shader::Shader(const std::string& name, const std::vector< Resource<ShaderPart> >& parts) : _name(name), _variant(0), _state(Linking), _cached(false), _uniforms({ -1, -1, -1, -1 }), _parts(parts) {
 
     // Create the new program
     _id = glCreateProgram();
 
+    // Try the binary cache before compiling anything
+    std::string path = cache_path();
+    _cached = !path.empty() && load_binary(path);
+    if (_cached) {
+        finish();
+        return;
+    }
+
     // Attach all the shader passes to it
     for (auto part : parts)
         glAttachShader(_id, part->id());
 
-    // Link the shader program
+    // Link the shader program, asking to keep its binary around if it's going to be cached.
+    // Like the compiles, the link isn't waited on until the program is needed.
+    if (!path.empty())
+        glProgramParameteri(_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(_id);
+    _cache_path = path;
+}
+
+bool Shader::ready() const {
+    if (_state == Linking && GLEW_KHR_parallel_shader_compile) {
+        int complete;
+        glGetProgramiv(_id, GL_COMPLETION_STATUS_KHR, &complete);
+        if (complete != GL_TRUE)
+            return false;
+    }
+
+    finish();
+    return _state == Linked;
+}
+
+void Shader::finish() const {
+    if (_state != Linking)
+        return;
 
     // Print an error message if there was a problem
+    bool compiled = true;
+    for (auto& part : _parts)
+        compiled = part->check() && compiled;
+
     int status;
     glGetProgramiv(_id, GL_LINK_STATUS, &status);
-    if (status != GL_TRUE) {
+    if (!compiled || status != GL_TRUE) {
         int length;
         glGetProgramiv(_id, GL_INFO_LOG_LENGTH, &length);
-        char* buffer = new char[length];
-        glGetProgramInfoLog(_id, length, 0, buffer);
-        Log::error("Shader program failed to link: " + name + "\n" + std::string(buffer));
+        char* buffer = new char[length + 1];
+        buffer[0] = 0;
+        glGetProgramInfoLog(_id, length + 1, 0, buffer);
+        Log::error("Shader program failed to link: " + _name + "\n" + std::string(buffer));
         delete[] buffer;
+        _state = Failed;
         return;
     }
-
-    // Use the program
-    glUseProgram(_id);
-
-    // Find common uniforms
-    _uniforms.model         = glGetUniformLocation(_id, "model");
-    _uniforms.view          = glGetUniformLocation(_id, "view");
-    _uniforms.projection    = glGetUniformLocation(_id, "projection");
-    _uniforms.diffuse       = glGetUniformLocation(_id, "diffuse");
-
-    glUseProgram(0);
+    _state = Linked;
+
+    if (!_cache_path.empty())
+        save_binary(_cache_path);
+
+    // Find every active uniform, and the common ones among them, which many shaders don't use
+    reflect();
+    auto find = [this](const char* name) { auto it = _locations.find(name); return it != _locations.end() ? it->second : -1; };
+    _uniforms.model         = find("model");
+    _uniforms.view          = find("view");
+    _uniforms.projection    = find("projection");
+    _uniforms.diffuse       = find("diffuse");
+
+    // Point the shared camera and object blocks, if there are any, at their bindings
+    unsigned int camera_block = glGetUniformBlockIndex(_id, "Camera");
+    if (camera_block != GL_INVALID_INDEX)
+        glUniformBlockBinding(_id, camera_block, CameraBlock::Binding);
+    unsigned int object_block = glGetUniformBlockIndex(_id, "Object");
+    if (object_block != GL_INVALID_INDEX)
+        glUniformBlockBinding(_id, object_block, ObjectBlock::Binding);
 
     gl_check();
 
     // Print success message
-    Log::success("Shader program linked: " + name + " (" + std::to_string(_id) + ")");
+    Log::success("Shader program " + std::string(_cached ? "loaded from cache: " : "linked: ") + _name + " (" + std::to_string(_id) + ")");
 }
 
 Shader::~Shader() {
     glDeleteProgram(_id);
 }
 
+bool Shader::uses(const Resource<ShaderPart>& part) const {
+    for (auto& other : _parts)
+        if (other.operator->() == part.operator->())
+            return true;
+    return false;
+}
+
+void Shader::set_cache_directory(const std::string& directory) {
+    cache_directory_setting() = directory;
+}
+
+const std::string& Shader::cache_directory() {
+    return cache_directory_setting();
+}
+
+std::string Shader::cache_path() const {
+    if (cache_directory().empty() || !GLEW_ARB_get_program_binary)
+        return "";
+
+    // Binaries only work with the driver which made them
+    std::string name = cache_name({ gl_string(GL_VENDOR), gl_string(GL_RENDERER), gl_string(GL_VERSION) }, _parts);
+    const std::string& directory = cache_directory();
+    char last = directory[directory.size() - 1];
+    return directory + (last == '/' || last == '\\' ? "" : "/") + name;
+}
+
+std::string Shader::cache_name(const std::vector<std::string>& driver, const std::vector< Resource<ShaderPart> >& parts) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (const std::string& value : driver)
+        hash_string(hash, value);
+    for (auto& part : parts) {
+        hash_string(hash, std::to_string(part->type()));
+        for (const std::string& source : part->sources())
+            hash_string(hash, source);
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", hash);
+    return name;
+}
+
+bool Shader::load_binary(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open())
+        return false;
+    std::vector<char> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    ifs.close();
+
+    // A small header, then the binary
+    unsigned int header[2];
+    if (data.size() <= sizeof(header))
+        return false;
+    std::memcpy(header, data.data(), sizeof(header));
+    if (header[0] != CACHE_MAGIC)
+        return false;
+
+    // Only hand GL formats it says it understands, since anything else is an error
+    int format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    std::vector<int> formats(format_count);
+    if (format_count > 0)
+        glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+    bool supported = false;
+    for (int format : formats)
+        supported = supported || unsigned(format) == header[1];
+    if (!supported)
+        return false;
+
+    glProgramBinary(_id, header[1], data.data() + sizeof(header), data.size() - sizeof(header));
+
+    // Drivers can turn down binaries from older versions of themselves, in which case the
+    // program is compiled as usual and the cache overwritten
+    int status;
+    glGetProgramiv(_id, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        Log::warning("Cached binary of shader " + _name + " was rejected, recompiling");
+        return false;
+    }
+
+    return true;
+}
+
+void Shader::save_binary(const std::string& path) const {
+    int length = 0;
+    glGetProgramiv(_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    GLenum format;
+    std::vector<char> data(length);
+    glGetProgramBinary(_id, length, &length, &format, data.data());
+    gl_check();
+
+    // Write next to the real file and move it over, so a half written binary is never loaded
+    std::string temporary = path + ".tmp";
+    std::ofstream ofs(temporary, std::ios::binary);
+    if (!ofs.is_open()) {
+        Log::warning("Couldn't write shader cache file: " + temporary);
+        return;
+    }
+
+    unsigned int header[2] = { CACHE_MAGIC, format };
+    ofs.write((const char*)header, sizeof(header));
+    ofs.write(data.data(), length);
+    ofs.close();
+
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        Log::warning("Couldn't write shader cache file: " + path);
+}
+
 void Shader::bind() const {
+    finish();
     glUseProgram(_id);
+    ++RenderStats::live().program_binds;
 }
 
 void Shader::unbind() const {
@@ -102,32 +309,50 @@ void Shader::unbind_all() {
 }
 
 void Shader::uniform(int location, int value) const {
+    if (!changed(location, &value, sizeof(value)))
+        return;
     glUniform1i(location, value);
+    ++RenderStats::live().uniform_uploads;
     gl_check();
 }
 
 void Shader::uniform(int location, float value) const {
+    if (!changed(location, &value, sizeof(value)))
+        return;
     glUniform1f(location, value);
+    ++RenderStats::live().uniform_uploads;
     gl_check();
 }
 
 void Shader::uniform(int location, const vec2& value) const {
+    if (!changed(location, &value, sizeof(value)))
+        return;
     glUniform2fv(location, 1, glm::value_ptr(value));
+    ++RenderStats::live().uniform_uploads;
     gl_check();
 }
 
 void Shader::uniform(int location, const vec3& value) const {
+    if (!changed(location, &value, sizeof(value)))
+        return;
     glUniform3fv(location, 1, glm::value_ptr(value));
+    ++RenderStats::live().uniform_uploads;
     gl_check();
 }
 
 void Shader::uniform(int location, const vec4& value) const {
+    if (!changed(location, &value, sizeof(value)))
+        return;
     glUniform4fv(location, 1, glm::value_ptr(value));
+    ++RenderStats::live().uniform_uploads;
     gl_check();
 }
 
 void Shader::uniform(int location, const mat4& value) const {
+    if (!changed(location, &value, sizeof(value)))
+        return;
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    ++RenderStats::live().uniform_uploads;
     gl_check();
 }
 
@@ -149,61 +374,112 @@ void Shader::uniform(ShaderUniform location, int value) const {
 
 void Shader::uniform_array(int array_location, const mat4* values, int count, int count_location) const {
     glUniformMatrix4fv(array_location, count, GL_FALSE, glm::value_ptr(values[0]));
-    if (count_location != -1) glUniform1i(count_location, count);
+    if (changed(count_location, &count, sizeof(count))) glUniform1i(count_location, count);
+    ++RenderStats::live().uniform_uploads;
     gl_check();
+
+    // Arrays aren't shadowed, so forget whatever was set on their elements one at a time
+    for (int i = 0; i < count && array_location != -1 && size_t(array_location + i) < _values.size(); ++i)
+        _values[array_location + i].size = 0;
 }
 
-int Shader::locate(const char* uniform_name) const {
+bool Shader::changed(int location, const void* value, size_t size) const {
+    if (location < 0)
+        return false;
+    if (size_t(location) >= _values.size())
+        _values.resize(location + 1, UniformValue());
 
-    glUseProgram(_id);
+    UniformValue& last = _values[location];
+    if (last.size == size && std::memcmp(last.data, value, size) == 0) {
+        ++RenderStats::live().uniform_skips;
+        return false;
+    }
+
+    last.size = size;
+    std::memcpy(last.data, value, size);
+    return true;
+}
+
+void Shader::reflect() const {
+    _locations.clear();
+    _values.clear();
+
+    int count, max_length;
+    glGetProgramiv(_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    std::vector<char> buffer(max_length + 1);
+    for (int i = 0; i < count; ++i) {
+        int length, size;
+        GLenum type;
+        glGetActiveUniform(_id, i, buffer.size(), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+
+        // Members of uniform blocks don't have locations
+        int location = glGetUniformLocation(_id, name.c_str());
+        if (location == -1)
+            continue;
+
+        // Arrays are reported as "name[0]", but can be located by their plain name too
+        _locations[name] = location;
+        if (size_t(location + size) > _values.size())
+            _values.resize(location + size, UniformValue());
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            _locations[name.substr(0, name.size() - 3)] = location;
+    }
+}
+
+int Shader::locate(const char* uniform_name) const {
+    finish();
 
-    int location = glGetUniformLocation(_id, uniform_name);
-    if (location == -1)
-        Log::warning("Uniform \"" + std::string(uniform_name) + "\" not found in shader \"" + _name + "\"");
+    auto it = _locations.find(uniform_name);
+    if (it != _locations.end())
+        return it->second;
 
-    return location;
+    // Remember missing uniforms as well, so they are only warned about once
+    Log::warning("Uniform \"" + std::string(uniform_name) + "\" not found in shader \"" + _name + "\"");
+    _locations.insert(std::make_pair(std::string(uniform_name), -1));
+    return -1;
 }
 
 Resource<ShaderPart> Shader::Preset::vert_standard() {
-    static Resource<ShaderPart> part(ShaderPart::Type::Vertex,
+    static Resource<ShaderPart> part(ShaderPart::Type::Vertex, std::vector<std::string>({
         "#version 330\n                                                         "
         "layout(location = 0)in vec3 vert_position;                             "
         "layout(location = 1)in vec3 vert_normal;                               "
         "layout(location = 2)in vec2 vert_uv;                                   "
-        "layout(location = 3)in vec4 vert_color;                                "
-        "uniform mat4 model;                                                    "
-        "uniform mat4 view;                                                     "
-        "uniform mat4 projection;                                               "
+        "layout(location = 3)in vec4 vert_color;                                ",
+        CameraBlock::glsl(),
+        ObjectBlock::glsl(),
         "out vec4 frag_position;                                                "
         "out vec4 frag_position_world;                                          "
         "out vec3 frag_normal;                                                  "
         "out vec2 frag_uv;                                                      "
         "out vec4 frag_color;                                                   "
+        "invariant gl_Position;                                                 "
         "void main() {                                                          "
-        "    mat4 transform = projection * view;                                "
         "    frag_position_world = model * vec4(vert_position, 1);              "
-        "    frag_position  = transform * frag_position_world;                  "
+        "    frag_position  = view_projection * frag_position_world;            "
         "    frag_normal    = normalize(vert_normal * inverse(mat3(model)));    "
         "    frag_uv        = vert_uv;                                          "
         "    frag_color     = vert_color;                                       "
         "    gl_Position    = frag_position;                                    "
         "}                                                                      "
-    );
+    }));
 
     return part;
 }
 
 Resource<ShaderPart> Shader::Preset::vert_skinned() {
-    static Resource<ShaderPart> part(ShaderPart::Type::Vertex,
+    static Resource<ShaderPart> part(ShaderPart::Type::Vertex, std::vector<std::string>({
         "#version 330\n                                                             "
         "layout(location = 1)in vec3 vert_normal;                                   "
         "layout(location = 2)in vec2 vert_uv;                                       "
         "layout(location = 3)in vec4 vert_color;                                    "
         "layout(location = 4)in vec4 vert_weight_indices;                          "
-        "layout(location = 5)in vec4 vert_weight_offsets[4];                        "
-        "uniform mat4 model;                                                        "
-        "uniform mat4 view;                                                         "
-        "uniform mat4 projection;                                                   "
+        "layout(location = 5)in vec4 vert_weight_offsets[4];                        ",
+        CameraBlock::glsl(),
+        ObjectBlock::glsl(),
         "uniform mat4 bone_transforms[128];                                         "
         "out vec4 frag_position;                                                    "
         "out vec3 frag_normal;                                                      "
@@ -232,7 +508,7 @@ Resource<ShaderPart> Shader::Preset::vert_skinned() {
         "       bone_transforms[int(vert_weight_indices[2])] * vert_weight_offsets[2] +  "
         "       bone_transforms[int(vert_weight_indices[3])] * vert_weight_offsets[3];   "
 
-        "   mat4 transform  = projection * view * model;                            "
+        "   mat4 transform  = view_projection * model;                              "
         "   frag_position   = transform * vert_position;                            "
         "   frag_normal     = normalize(vert_normal * inverse(mat3(model)));        "
         "   frag_uv         = vert_uv;                                              "
@@ -245,7 +521,63 @@ Resource<ShaderPart> Shader::Preset::vert_skinned() {
 
         "   gl_Position     = frag_position;                                        "
         "}                                                                          "
-    );
+    }));
+
+    return part;
+}
+
+Resource<ShaderPart> Shader::Preset::vert_position() {
+    //
+    // Only transforms positions, for depth-only passes. It computes gl_Position exactly as
+    // vert_standard does, and both declare it invariant, so the depth it writes matches.
+    //
+    static Resource<ShaderPart> part(ShaderPart::Type::Vertex, std::vector<std::string>({
+        "#version 330\n                                                         "
+        "layout(location = 0)in vec3 vert_position;                             ",
+        CameraBlock::glsl(),
+        ObjectBlock::glsl(),
+        "invariant gl_Position;                                                 "
+        "void main() {                                                          "
+        "    vec4 position_world = model * vec4(vert_position, 1);              "
+        "    gl_Position    = view_projection * position_world;                 "
+        "}                                                                      "
+    }));
+
+    return part;
+}
+
+Resource<ShaderPart> Shader::Preset::vert_indirect() {
+    //
+    // Same as vert_standard, but the model matrix is fetched from the per-draw
+    // storage buffer which Render fills for multi-draw-indirect submission.
+    //
+    static Resource<ShaderPart> part(ShaderPart::Type::Vertex, std::vector<std::string>({
+        "#version 430\n                                                         "
+        "#extension GL_ARB_shader_draw_parameters : require\n                   "
+        "layout(location = 0)in vec3 vert_position;                             "
+        "layout(location = 1)in vec3 vert_normal;                               "
+        "layout(location = 2)in vec2 vert_uv;                                   "
+        "layout(location = 3)in vec4 vert_color;                                "
+        "layout(std430, binding = 0) readonly buffer DrawData {                 "
+        "    mat4 models[];                                                     "
+        "};                                                                     ",
+        CameraBlock::glsl(),
+        "out vec4 frag_position;                                                "
+        "out vec4 frag_position_world;                                          "
+        "out vec3 frag_normal;                                                  "
+        "out vec2 frag_uv;                                                      "
+        "out vec4 frag_color;                                                   "
+        "invariant gl_Position;                                                 "
+        "void main() {                                                          "
+        "    mat4 model = models[gl_BaseInstanceARB];                           "
+        "    frag_position_world = model * vec4(vert_position, 1);              "
+        "    frag_position  = view_projection * frag_position_world;            "
+        "    frag_normal    = normalize(vert_normal * inverse(mat3(model)));    "
+        "    frag_uv        = vert_uv;                                          "
+        "    frag_color     = vert_color;                                       "
+        "    gl_Position    = frag_position;                                    "
+        "}                                                                      "
+    }));
 
     return part;
 }
@@ -337,18 +669,27 @@ Resource<ShaderPart> Shader::Preset::frag_white() {
     return part;
 }
 
-Resource<ShaderPart> Shader::Preset::frag_solid() {
+Resource<ShaderPart> Shader::Preset::frag_empty() {
     static Resource<ShaderPart> part(ShaderPart::Type::Fragment,
         "#version 330\n                 "
-        "uniform vec4 color;            "
-        "out vec4 pixel_color;          "
         "void main() {                  "
-        "    pixel_color = color;       "
         "}                              "
     );
     return part;
 }
 
+Resource<ShaderPart> Shader::Preset::frag_solid() {
+    static Resource<ShaderPart> part(ShaderPart::Type::Fragment, std::vector<std::string>({
+        "#version 330\n                 ",
+        ObjectBlock::glsl(),
+        "out vec4 pixel_color;          "
+        "void main() {                  "
+        "    pixel_color = object_color;"
+        "}                              "
+    }));
+    return part;
+}
+
 Resource<ShaderPart> Shader::Preset::frag_flat() {
     static Resource<ShaderPart> part(ShaderPart::Type::Fragment,
         "#version 330\n                                                 "
@@ -392,4 +733,14 @@ Resource<Shader> Shader::Preset::coords() {
 Resource<Shader> Shader::Preset::depth() {
     static Resource<Shader> shader("Depth", vert_standard(), frag_depth());
     return shader;
-}
\ No newline at end of file
+}
+
+Resource<Shader> Shader::Preset::placeholder() {
+    static Resource<Shader> shader("Placeholder", vert_standard(), frag_solid());
+    return shader;
+}
+
+Resource<Shader> Shader::Preset::depth_only() {
+    static Resource<Shader> shader("Depth Only", vert_position(), frag_empty());
+    return shader;
+}
@@ -0,0 +1,87 @@
+#include <string>
+#include "frame/Log.h"
+#include "frame_gl/data/ShaderVariants.h"
+using namespace frame;
+
+namespace
+{
+    const size_t MAX_FLAGS = sizeof(ShaderVariants::Key) * 8;
+}
+
+ShaderVariants::ShaderVariants(const std::string& name, const std::vector<Stage>& stages, const std::vector<std::string>& flags)
+    : _name(name), stages(stages), _flags(flags) {
+
+    if (_flags.size() > MAX_FLAGS) {
+        Log::error("Shader variants " + name + " have more than " + std::to_string(MAX_FLAGS) + " flags, ignoring the rest");
+        _flags.resize(MAX_FLAGS);
+    }
+
+    // Work out which flags each stage mentions at all, so it's only specialized on those
+    for (const Stage& stage : stages) {
+        Key mask = 0;
+        for (size_t i = 0; i < _flags.size(); ++i)
+            for (const std::string& source : stage.sources)
+                if (source.find(_flags[i]) != std::string::npos)
+                    mask |= Key(1) << i;
+        stage_masks.push_back(mask);
+    }
+}
+
+ShaderVariants::Key ShaderVariants::flag(const std::string& name) const {
+    for (size_t i = 0; i < _flags.size(); ++i)
+        if (_flags[i] == name)
+            return Key(1) << i;
+
+    Log::warning("Shader variants " + _name + " have no flag " + name);
+    return 0;
+}
+
+Resource<Shader> ShaderVariants::get(Key key) {
+    auto it = variants.find(key);
+    if (it != variants.end())
+        return it->second;
+
+    // Name the variant after its flags, so it can be told apart in the log
+    std::string name = _name + " [";
+    for (size_t i = 0; i < _flags.size(); ++i)
+        if (key & (Key(1) << i))
+            name += (name[name.size() - 1] == '[' ? "" : "|") + _flags[i];
+    name += "]";
+
+    std::vector< Resource<ShaderPart> > shader_parts;
+    for (size_t i = 0; i < stages.size(); ++i)
+        shader_parts.push_back(part(i, key & stage_masks[i]));
+
+    Resource<Shader> shader(name, shader_parts);
+    shader->_variant = key;
+    variants.insert(std::make_pair(key, shader));
+    return shader;
+}
+
+Resource<ShaderPart> ShaderVariants::part(size_t stage, Key key) {
+    auto it = parts.find(std::make_pair(stage, key));
+    if (it != parts.end())
+        return it->second;
+
+    Resource<ShaderPart> part(stages[stage].type, specialize(stages[stage].sources, key));
+    parts.insert(std::make_pair(std::make_pair(stage, key), part));
+    return part;
+}
+
+std::vector<std::string> ShaderVariants::specialize(const std::vector<std::string>& sources, Key key) const {
+    std::string defines;
+    for (size_t i = 0; i < _flags.size(); ++i)
+        if (key & (Key(1) << i))
+            defines += "#define " + _flags[i] + "\n";
+
+    // The defines have to come after #version, which has to be the first line
+    std::vector<std::string> result = sources;
+    if (result.empty())
+        return result;
+    size_t line_end = result[0].find('\n');
+    if (result[0].compare(0, 8, "#version") == 0 && line_end != std::string::npos)
+        result[0].insert(line_end + 1, defines);
+    else
+        result[0].insert(0, defines);
+    return result;
+}
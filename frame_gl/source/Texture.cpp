@@ -9,10 +9,32 @@
 //#include <gli/save.hpp>
 #include "frame/Log.h"
 #include "frame_gl/data/Texture.h"
+#include "frame_gl/data/RenderStats.h"
 #include "frame_gl/error.h"
 using namespace frame;
 
-Texture::Texture(const ivec2& size, bool multisample) : _size(size), _multisample(multisample) {
+namespace
+{
+    // Internal format, and a matching external format and type for allocating without data
+    struct FormatInfo {
+        GLenum internal;
+        GLenum external;
+        GLenum type;
+    };
+
+    FormatInfo format_info(Texture::Format format) {
+        switch (format) {
+            case Texture::RGBA8:        return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE };
+            case Texture::SRGB8_A8:     return { GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE };
+            case Texture::RGB10_A2:     return { GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV };
+            case Texture::R11G11B10F:   return { GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV };
+            case Texture::RGBA16F:      return { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT };
+            default:                    return { GL_RGBA32F, GL_RGBA, GL_FLOAT };
+        }
+    }
+}
+
+Texture::Texture(const ivec2& size, bool multisample, Format format) : _size(size), _multisample(multisample), _format(format) {
     glGenTextures(1, &_id);
     /*if (_multisample) {
         _target = GL_TEXTURE_2D_MULTISAMPLE;
@@ -27,8 +49,9 @@ Texture::Texture(const ivec2& size, bool multisample) : _size(size), _multisampl
     } else {*/
 
     _target = GL_TEXTURE_2D;
+    FormatInfo info = format_info(format);
     glBindTexture(GL_TEXTURE_2D, _id);
-    glTexImage2D(GL_TEXTURE_2D, 0, (int)GL_RGBA32F_ARB, size.x, size.y, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, (int)info.internal, size.x, size.y, 0, info.external, info.type, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (int)GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (int)GL_CLAMP_TO_EDGE);
@@ -45,7 +68,7 @@ Texture::Texture(const ivec2& size, bool multisample) : _size(size), _multisampl
     Log::success("Texture (" + std::to_string(size.x) + "x" + std::to_string(size.y) + ") created with ID " + std::to_string(_id));
 }
 
-Texture::Texture(const std::string& filename) {
+Texture::Texture(const std::string& filename) : _multisample(false), _format(RGBA8) {
 
     /*
     if(std::strstr(filename.c_str(), ".dds") > 0 || std::strstr(filename.c_str(), ".ktx") > 0)
@@ -100,6 +123,7 @@ void Texture::set_size(const ivec2& size) {
 void Texture::bind(unsigned int texture_unit) const {
     glActiveTexture(GL_TEXTURE0 + texture_unit);
     glBindTexture(_target, _id);
+    ++RenderStats::live().texture_binds;
 }
 
 void Texture::unbind() const {
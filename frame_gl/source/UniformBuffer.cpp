@@ -0,0 +1,53 @@
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include "frame_gl/data/UniformBuffer.h"
+#include "frame_gl/data/RenderStats.h"
+#include "frame_gl/error.h"
+using namespace frame;
+
+UniformBuffer::UniformBuffer(size_t size) : _size(size) {
+    glGenBuffers(1, &_id);
+    glBindBuffer(GL_UNIFORM_BUFFER, _id);
+    glBufferData(GL_UNIFORM_BUFFER, size, 0, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    gl_check();
+}
+
+UniformBuffer::~UniformBuffer() {
+    glDeleteBuffers(1, &_id);
+}
+
+void UniformBuffer::write(const void* data, size_t size, size_t offset) {
+    glBindBuffer(GL_UNIFORM_BUFFER, _id);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    RenderStats::live().buffer_bytes += size;
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    gl_check();
+}
+
+void UniformBuffer::bind(unsigned int binding) const {
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, _id);
+    gl_check();
+}
+
+const char* CameraBlock::glsl() {
+    return
+        "layout(std140) uniform Camera {                                        "
+        "    mat4 view;                                                         "
+        "    mat4 projection;                                                   "
+        "    mat4 view_projection;                                              "
+        "    mat4 inverse_view;                                                 "
+        "    mat4 inverse_projection;                                           "
+        "    vec2 screen_size;                                                  "
+        "    float time;                                                        "
+        "};                                                                     ";
+}
+
+const char* ObjectBlock::glsl() {
+    return
+        "layout(std140) uniform Object {                                        "
+        "    mat4 model;                                                        "
+        "    vec4 object_color;                                                 "
+        "    vec4 object_params;                                                "
+        "};                                                                     ";
+}
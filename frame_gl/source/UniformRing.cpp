@@ -0,0 +1,100 @@
+#define GLEW_STATIC
+#include <string>
+#include <cstring>
+#include <GL/glew.h>
+#include "frame/Log.h"
+#include "frame_gl/data/UniformRing.h"
+#include "frame_gl/data/RenderStats.h"
+#include "frame_gl/error.h"
+using namespace frame;
+
+UniformRing::UniformRing(size_t frame_size, unsigned int frames)
+    : frames(frames), frame(0), cursor(0), flushed(0), reallocate(false), fences(frames, nullptr) {
+
+    // Every block, and so every region, has to start on the driver's offset alignment
+    GLint offset_alignment;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+    alignment = size_t(offset_alignment);
+    _frame_size = (frame_size + alignment - 1) / alignment * alignment;
+
+    staging.resize(_frame_size);
+    glGenBuffers(1, &buffer);
+    allocate();
+}
+
+UniformRing::~UniformRing() {
+    for (void* fence : fences)
+        if (fence) glDeleteSync((GLsync)fence);
+    glDeleteBuffers(1, &buffer);
+}
+
+void UniformRing::next_frame() {
+
+    // Fence off the region we just finished with
+    if (fences[frame]) glDeleteSync((GLsync)fences[frame]);
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // Wait for the GPU to finish reading the next region, which should almost never block
+    frame = (frame + 1) % frames;
+    if (fences[frame]) {
+        glClientWaitSync((GLsync)fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        glDeleteSync((GLsync)fences[frame]);
+        fences[frame] = nullptr;
+    }
+
+    cursor = flushed = 0;
+}
+
+size_t UniformRing::push(const void* data, size_t size) {
+    size_t offset = (cursor + alignment - 1) / alignment * alignment;
+
+    // Double the regions if this frame doesn't fit. The buffer is reallocated on the
+    // next flush, and everything pushed this frame is uploaded to it again.
+    if (offset + size > _frame_size) {
+        while (offset + size > _frame_size)
+            _frame_size *= 2;
+        staging.resize(_frame_size);
+        reallocate = true;
+        Log::warning("Uniform ring grew to " + std::to_string(_frame_size) + " bytes per frame");
+    }
+
+    memcpy(staging.data() + offset, data, size);
+    cursor = offset + size;
+    return offset;
+}
+
+void UniformRing::flush() {
+    if (reallocate) {
+        allocate();
+        flushed = 0;
+    }
+
+    if (cursor == flushed)
+        return;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, frame * _frame_size + flushed, cursor - flushed, staging.data() + flushed);
+    RenderStats::live().buffer_bytes += cursor - flushed;
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    flushed = cursor;
+    gl_check();
+}
+
+void UniformRing::bind(unsigned int binding, size_t offset, size_t size) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, frame * _frame_size + offset, size);
+}
+
+void UniformRing::allocate() {
+
+    // Orphaning the old storage means in-flight regions are safe, so their fences can go
+    for (void*& fence : fences) {
+        if (fence) glDeleteSync((GLsync)fence);
+        fence = nullptr;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, frames * _frame_size, 0, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    reallocate = false;
+    gl_check();
+}
@@ -1,6 +1,11 @@
 #define GLEW_STATIC
 #include <vector>
-#include <set>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
@@ -8,12 +13,26 @@
 #include "frame_gl/systems/Window.h"
 #include "frame_gl/systems/Render.h"
 #include "frame_gl/data/Shader.h"
+#include "frame_gl/data/GpuProfiler.h"
 #include "frame_gl/error.h"
 #include "frame_gl/math.h"
 using namespace frame;
 
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // How much of a frame limiter wait is spun out rather than slept, since sleeps can overshoot
+    const std::chrono::microseconds SPIN_TIME(2000);
+
+    // Weight of each new sample in the rolling latency average
+    const double SMOOTHING = 0.1;
+}
+
 Window::Window(ivec2 size, bool resizeable, FitMode fit_mode, bool vsync, const glm::vec3& clear_color)
-: _size(size), fit_mode(fit_mode), vsync(vsync), clear_color(clear_color) {
+: _size(size), fit_mode(fit_mode), vsync(vsync), clear_color(clear_color), render_thread(nullptr), composited(false),
+  frame_limit(0.0), max_frames_in_flight(0), input_pending(false), frame_has_input(false), presented_input(false) {
+    reset_latency();
 
     // Initialize GLFW, if this is the first window
     if (count() == 0) {
@@ -35,6 +54,7 @@ Window::Window(ivec2 size, bool resizeable, FitMode fit_mode, bool vsync, const
 
     // Create a window
     if (!resizeable) glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GL_TRUE);
     window = glfwCreateWindow(size.x, size.y, project_name.c_str(), 0, 0);
     if (!window) {
         Log::error("Failed to open window");
@@ -75,6 +95,9 @@ Window::Window(ivec2 size, bool resizeable, FitMode fit_mode, bool vsync, const
 
 Window::~Window() {
 
+    // Take the context back before the window goes
+    delete render_thread;
+
     // Decrement window count
     --count();
 
@@ -108,9 +131,10 @@ void Window::setup() {
             "layout(location = 0)in vec3 vert_position;                 "
             "layout(location = 2)in vec2 vert_uv;                       "
             "uniform mat4 transform;                                    "
+            "uniform vec2 uv_scale;                                     "
             "out vec2 frag_uv;                                          "
             "void main() {                                              "
-            "   frag_uv       = vert_uv;                                "
+            "   frag_uv       = vert_uv * uv_scale;                     "
             "   gl_Position   = transform * vec4(vert_position, 1.0);   "
             "}                                                          "
         ),
@@ -120,17 +144,31 @@ void Window::setup() {
             "in vec2 frag_uv;                               "
             "out vec4 pixel_color;                          "
             "uniform sampler2D texture;                     "
+            "uniform vec2 uv_max;                           "
             "void main() {                                  "
-            "   pixel_color = texture2D(texture, frag_uv); "
+            "   pixel_color = texture2D(texture, min(frag_uv, uv_max));"
             "}                                              "
         )
     );
 
     transform_location = shader->locate("transform");
+    uv_scale_location = shader->locate("uv_scale");
+    uv_max_location = shader->locate("uv_max");
 }
 
 void Window::teardown() {
 
+    // Let the last frame finish, and stop the Render system waiting on us
+    if (render_thread) {
+        render_thread->wait();
+        if (Render* render = frame()->systems().get<Render>())
+            render->set_render_thread(nullptr);
+    }
+
+    for (void* fence : frame_fences)
+        glDeleteSync((GLsync)fence);
+    frame_fences.clear();
+
     // Delete the buffer mesh & shader
     delete mesh;
     delete shader;
@@ -150,10 +188,240 @@ Window* Window::get_window(Frame* frame) {
     return nullptr;
 }
 
+void Window::set_render_thread(bool threaded) {
+    if (threaded == this->threaded())
+        return;
+
+    if (threaded) {
+        GLFWwindow* context = window;
+        render_thread = new RenderThread([context]() { glfwMakeContextCurrent(context); }, []() { glfwMakeContextCurrent(nullptr); });
+    } else {
+        delete render_thread;
+        render_thread = nullptr;
+    }
+
+    if (Render* render = frame()->systems().get<Render>())
+        render->set_render_thread(render_thread);
+}
+
 void Window::step() {
 
-    // Select the window context
+    // Wait for the last frame to be shown, if it's still going, and select the window context
+    if (render_thread)
+        render_thread->wait();
     glfwMakeContextCurrent(window);
+    record_latency();
+
+    // This frame was made after the input polled in the last step, so it's the one which shows it
+    frame_has_input = input_pending;
+    frame_input_time = input_time;
+    input_pending = false;
+
+    update_display_buffers();
+
+    // The composite samples every display target, so the render graph runs it after everything drawn to them
+    Render* render = frame()->systems().get<Render>();
+    if (render) {
+        RenderGraph& graph = render->graph();
+        std::vector<RenderGraph::Handle> reads;
+        std::vector<DisplayBuffer> buffers = display_buffers;
+        ivec2 window_size = _size;
+        for (DisplayBuffer& buffer : buffers) {
+            RenderGraph::Handle target = graph.import(buffer.target->frame_buffer());
+            buffer.resolved = graph.screen();
+
+            // Multisampled buffers can't be sampled, so unless one is blitted straight to the
+            // screen, it's resolved into a transient target from the graph's pool first
+            if (buffer.target->multisample() && !(buffers.size() == 1 && can_blit(buffer, window_size))) {
+                RenderGraph::Handle resolved = graph.create(buffer.viewport, buffer.target->color_format());
+                FrameBuffer* source = buffer.target->frame_buffer();
+                ivec2 viewport = buffer.viewport;
+                graph.add_pass("Window resolve", resolved, { target }, [render, source, resolved, viewport]() {
+                    source->resolve_to(render->graph().buffer(resolved), viewport);
+                });
+                buffer.resolved = resolved;
+                target = resolved;
+            }
+            reads.push_back(target);
+        }
+
+        // The pass keeps its own copy of the sizes, since events polled during the frame can change them
+        composited = false;
+        graph.add_pass("Window composite", graph.screen(), reads, [this, render, buffers, window_size]() {
+            composited = composite(buffers, window_size, &render->graph());
+        });
+    }
+
+    // Check for window close request. Events are handled before the frame goes to the render
+    // thread, while this thread still has the context, since their listeners may touch GL.
+    //
+    // TODO: Stopping the frame on window-removal should be optional!
+    //
+    glfwPollEvents();
+    if (glfwWindowShouldClose(window))
+        frame().stop();
+
+    // Run the graph and show the result, either here or on the render thread
+    if (render && render_thread) {
+        render->set_render_thread(render_thread);
+        render_thread->submit([this, render]() {
+            render->execute_graph();
+            present();
+        });
+    } else {
+        if (render) render->execute_graph();
+        else composited = composite(display_buffers, _size, nullptr);
+        present();
+    }
+}
+
+void Window::present() {
+    limit_frame_rate();
+
+    // Finally, blit to the screen
+    if (composited) {
+        glfwSwapBuffers(window);
+        limit_frames_in_flight();
+        gl_check();
+
+        // Note when the input this frame reacted to made it out
+        presented_input = frame_has_input;
+        presented_input_time = frame_input_time;
+        presented_time = Clock::now();
+    }
+
+    // The window marks the end of each frame, so read back whatever timings have arrived
+    GpuProfiler::get().next_frame();
+
+    gl_check();
+}
+
+void Window::limit_frame_rate() {
+    if (frame_limit <= 0.0)
+        return;
+
+    Clock::time_point now = Clock::now();
+    Clock::duration interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frame_limit));
+
+    // Running behind, so start pacing again from now rather than rushing to catch up
+    if (next_present <= now) {
+        next_present = now + interval;
+        return;
+    }
+
+    // Sleep for most of the wait, then spin until it's time
+    Clock::duration sleep = next_present - now - SPIN_TIME;
+    if (sleep > Clock::duration::zero())
+        std::this_thread::sleep_for(sleep);
+    while (Clock::now() < next_present)
+        std::this_thread::yield();
+
+    // Keep frames on an even schedule, whatever this one overshot by
+    next_present += interval;
+}
+
+void Window::limit_frames_in_flight() {
+
+    // Drop any fences left over from a higher limit
+    if (max_frames_in_flight == 0) {
+        for (void* fence : frame_fences)
+            glDeleteSync((GLsync)fence);
+        frame_fences.clear();
+        return;
+    }
+
+    // Wait for the GPU to finish the swap from max_frames_in_flight frames ago
+    frame_fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    while (frame_fences.size() > max_frames_in_flight) {
+        GLsync fence = (GLsync)frame_fences.front();
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        glDeleteSync(fence);
+        frame_fences.pop_front();
+    }
+}
+
+void Window::input_received() {
+    if (!input_pending) {
+        input_pending = true;
+        input_time = Clock::now();
+    }
+}
+
+void Window::record_latency() {
+    if (!presented_input)
+        return;
+    presented_input = false;
+
+    double latency_ms = std::chrono::duration<double, std::milli>(presented_time - presented_input_time).count();
+    _latency.last_ms = latency_ms;
+    _latency.average_ms = _latency.samples == 0 ? latency_ms : _latency.average_ms + (latency_ms - _latency.average_ms) * SMOOTHING;
+    _latency.max_ms = std::max(_latency.max_ms, latency_ms);
+    ++_latency.samples;
+}
+
+void Window::reset_latency() {
+    _latency.last_ms = _latency.average_ms = _latency.max_ms = 0.0;
+    _latency.samples = 0;
+}
+
+void Window::update_display_buffers() {
+
+    // Gather the display targets in priority order. Only the first target of each priority is
+    // shown, as it always has been.
+    display_targets.clear();
+    for (auto buffer : node<RenderTarget>())
+        if (buffer->display_layer() != -1)
+            display_targets.push_back(buffer);
+    std::stable_sort(display_targets.begin(), display_targets.end(), RenderTarget::compare);
+    display_targets.erase(std::unique(display_targets.begin(), display_targets.end(), [](const RenderTarget* a, const RenderTarget* b) {
+        return a->display_priority() == b->display_priority();
+    }), display_targets.end());
+
+    // Transforms only need working out again when a target, its size or the window's size changes
+    display_buffers.resize(display_targets.size());
+    for (size_t i = 0; i < display_targets.size(); ++i) {
+        DisplayBuffer& buffer = display_buffers[i];
+        RenderTarget* target = display_targets[i];
+        if (buffer.target != target || buffer.size != target->size() || buffer.window_size != _size) {
+            buffer.target = target;
+            buffer.size = target->size();
+            buffer.window_size = _size;
+            calculate_buffer_transform(target, buffer.transform);
+        }
+        buffer.viewport = target->viewport();
+        buffer.allocation = target->allocation();
+
+        // Resolving is only set up once the composite pass is declared
+        buffer.resolved = 0;
+    }
+}
+
+bool Window::can_blit(const DisplayBuffer& buffer, const ivec2& window_size) const {
+    const RenderTarget* target = buffer.target;
+
+    // The quad blends over the clear color and converts sRGB, neither of which a blit does
+    if (target->clear_color().a < 1.0f || target->color_format() == Texture::SRGB8_A8)
+        return false;
+
+    // Multisampled buffers can only be resolved without scaling
+    if (target->multisample() && buffer.viewport != window_size)
+        return false;
+
+    // Every fit mode stretches a buffer the size of the window over the whole of it
+    return fit_mode == Stretch || buffer.size == window_size;
+}
+
+bool Window::composite(const std::vector<DisplayBuffer>& buffers, const ivec2& window_size, const RenderGraph* graph) {
+    GpuProfiler::get().begin("Window composite");
+
+    // A single buffer covering the whole window can be copied straight over, without a pass
+    // over the screen to clear it and another to draw the buffer on a quad
+    if (buffers.size() == 1 && can_blit(buffers.front(), window_size)) {
+        const DisplayBuffer& display_buffer = buffers.front();
+        display_buffer.target->frame_buffer()->blit_to_screen(display_buffer.viewport, window_size);
+        GpuProfiler::get().end("Window composite");
+        return true;
+    }
 
     // Set up OpenGL state
 
@@ -175,40 +443,39 @@ void Window::step() {
 
     gl_check();
 
-    // Initialize a list to contain all display buffers
-    std::set< RenderTarget*, std::function<bool (const RenderTarget*, const RenderTarget*)> > buffers(RenderTarget::compare);
-    //Render* render;
-    //RenderTarget* buffer;
-
-    //// If we this frame has a display buffer, add it to the list of buffers to draw to screen
-    //if ((render = frame()->systems().get<Render>()) && (buffer = render->display_target()))
-    //    buffers.insert(buffer);
-
-    // Build a list of all display targets from this frame
-    for (auto buffer : node<RenderTarget>())
-        if (buffer->display_layer() != -1)
-            buffers.insert(buffer);
-
-    //// Add the display buffers from all subframes
-    //for (Frame *f : node<Frame>())
-    //    if ((render = f->systems().get<Render>()) && (buffer = render->display_target()))
-    //        buffers.insert(buffer);
-
     // Only bother setting up stuff if we found some buffers
-    if (buffers.size() > 0) {
+    if (!buffers.empty()) {
 
         // Set the viewport
-        glViewport(0, 0, size().x, size().y);
+        glViewport(0, 0, window_size.x, window_size.y);
 
         // Set up the final-pass shader
         shader->bind();
 
         // Render each of the buffers to the screen
-        for (RenderTarget* buffer : buffers) {
-
-            // Find the transform to use for the drawing of this buffer and give it to the shader
-            calculate_buffer_transform(buffer, transform);
-            shader->uniform(transform_location, transform);
+        for (const DisplayBuffer& display_buffer : buffers) {
+            RenderTarget* target = display_buffer.target;
+
+            // Sample the resolved copy of multisampled buffers
+            FrameBuffer* buffer = target->frame_buffer();
+            vec2 allocation(display_buffer.allocation);
+            if (graph && display_buffer.resolved != graph->screen()) {
+                buffer = graph->buffer(display_buffer.resolved);
+                allocation = vec2(buffer->allocation());
+            }
+
+            // Give the buffer's transform to the shader
+            shader->uniform(transform_location, display_buffer.transform);
+
+            // Stretch the rendered part of the buffer's storage over the whole quad, without
+            // filtering in any texels from beyond it
+            vec2 viewport(display_buffer.viewport);
+            shader->uniform(uv_scale_location, viewport / allocation);
+            shader->uniform(uv_max_location, (viewport - 0.5f) / allocation);
+
+            // sRGB buffers are decoded as they're sampled, so encode them again on the way to the screen
+            if (buffer->color_format() == Texture::SRGB8_A8) glEnable(GL_FRAMEBUFFER_SRGB);
+            else glDisable(GL_FRAMEBUFFER_SRGB);
 
             // Bind the display buffer's texture for reading, and render it to the screen buffer
             buffer->bind_texture(0);
@@ -218,22 +485,12 @@ void Window::step() {
 
         // We are done with this shader now
         shader->unbind();
-
-        // Finally, blit to the screen
-        glfwSwapBuffers(window);
-
+        glDisable(GL_FRAMEBUFFER_SRGB);
         gl_check();
     }
 
-    // Check for window close request
-    //
-    // TODO: Stopping the frame on window-removal should be optional!
-    //
-    glfwPollEvents();
-    if (glfwWindowShouldClose(window))
-        frame().stop();
-
-    gl_check();
+    GpuProfiler::get().end("Window composite");
+    return !buffers.empty();
 }
 
 void Window::calculate_buffer_transform(RenderTarget* buffer, mat4& transform) {
@@ -241,10 +498,6 @@ void Window::calculate_buffer_transform(RenderTarget* buffer, mat4& transform) {
     // TODO: Update the transform based on the render buffer's ratio,
     //       the screen size ratio, and the fill mode.
     //
-    // TODO: Move this into resize somehow... doesn't need to change
-    //       every freaking step... Unless, I suppose, the render target
-    //       changes size.
-    //
     if (fit_mode == Stretch) {
 
         // No transform is necessary to stretch the buffer to fill the screen.
@@ -280,22 +533,26 @@ void Window::resize_callback(GLFWwindow* window, int width, int height) {
 }
 
 void Window::keyboard_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
-    reinterpret_cast<Window*>(glfwGetWindowUserPointer(window))
-        ->keyboard(key, scancode, action, mods);
+    Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    w->input_received();
+    w->keyboard(key, scancode, action, mods);
 }
 
 void Window::character_callback(GLFWwindow* window, unsigned int codepoint) {
-    reinterpret_cast<Window*>(glfwGetWindowUserPointer(window))
-        ->character(codepoint);
+    Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    w->input_received();
+    w->character(codepoint);
 }
 
 void Window::mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
-    reinterpret_cast<Window*>(glfwGetWindowUserPointer(window))
-        ->mouse_button(button, action, mods);
+    Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    w->input_received();
+    w->mouse_button(button, action, mods);
 }
 
 void Window::mouse_position_callback(GLFWwindow* glfw_window, double x, double y) {
     Window* window = reinterpret_cast<Window*>(glfwGetWindowUserPointer(glfw_window));
+    window->input_received();
 
     // Scale the position to the main buffer
     //
@@ -320,11 +577,45 @@ void Window::mouse_position_callback(GLFWwindow* glfw_window, double x, double y
 }
 
 void Window::mouse_scroll_callback(GLFWwindow* window, double dx, double dy) {
-    reinterpret_cast<Window*>(glfwGetWindowUserPointer(window))
-        ->mouse_scroll(vec2(dx, dy));
+    Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    w->input_received();
+    w->mouse_scroll(vec2(dx, dy));
 }
 
 int& Window::count() {
     static int _count = 0;
     return _count;
 }
+
+void Window::load_prototypes(std::back_insert_iterator< std::vector< CommandPrototype > >& commands) {
+    *(commands++) = {
+        Command("window", "[latency|limit <fps>|inflight <frames>]"),
+        "Show input to present latency, cap the frame rate, or limit the frames queued ahead of the GPU",
+        ""
+    };
+}
+
+void Window::handle(Command command) {
+    if (command.arg_count() == 0) {
+        command.add_result_line("Please specify an option");
+        return;
+    }
+
+    if (command.arg(0) == "latency") {
+        char line[96];
+        snprintf(line, sizeof(line), "Input latency: last %.2fms, average %.2fms, max %.2fms over %u frames",
+                 _latency.last_ms, _latency.average_ms, _latency.max_ms, (unsigned int)_latency.samples);
+        command.add_result_line(line);
+        command.add_result_line("Frame limit: " + (frame_limit > 0.0 ? std::to_string(int(frame_limit)) + "fps" : std::string("off")));
+        command.add_result_line("Frames in flight: " + (max_frames_in_flight > 0 ? std::to_string(max_frames_in_flight) : std::string("unlimited")));
+        reset_latency();
+
+    } else if (command.arg(0) == "limit" && command.arg_count() > 1) {
+        set_frame_limit(std::atof(command.arg(1).c_str()));
+        command.add_result_line(frame_limit > 0.0 ? "Frame rate limited to " + std::to_string(int(frame_limit)) + "fps" : "Frame rate unlimited");
+
+    } else if (command.arg(0) == "inflight" && command.arg_count() > 1) {
+        set_max_frames_in_flight((unsigned int)std::max(0, std::atoi(command.arg(1).c_str())));
+        command.add_result_line("Frames in flight: " + (max_frames_in_flight > 0 ? std::to_string(max_frames_in_flight) : std::string("unlimited")));
+    }
+}
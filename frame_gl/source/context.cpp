@@ -0,0 +1,20 @@
+#include <GLFW/glfw3.h>
+#if FRAME_GL_EGL
+#include <EGL/egl.h>
+#endif
+#include "frame_gl/context.h"
+using namespace frame;
+
+bool frame::gl_context_current() {
+
+    // EGL first, since headless runs never initialize GLFW, which complains when asked
+    #if FRAME_GL_EGL
+    if (eglGetCurrentContext() != EGL_NO_CONTEXT)
+        return true;
+    #endif
+
+    if (glfwGetCurrentContext() != 0)
+        return true;
+
+    return false;
+}
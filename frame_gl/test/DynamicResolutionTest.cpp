@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <cmath>
+#include "frame_gl/systems/DynamicResolution.h"
+using namespace frame;
+
+//
+// The scale controller only does arithmetic on frame times, so it's tested on its own rather
+// than through a running Frame.
+//
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* name) {
+        std::printf("%s: %s\n", condition ? "pass" : "FAIL", name);
+        if (!condition) ++failures;
+    }
+
+    bool near(float a, float b) {
+        return std::abs(a - b) < 1e-4f;
+    }
+
+    float next(float scale, float gpu_ms) {
+        return DynamicResolution::next_scale(scale, gpu_ms, 16.0f, 0.5f, 1.0f);
+    }
+}
+
+int main() {
+    // Over budget drops straight to the scale whose area should fit 85% of the budget
+    check(near(next(1.0f, 20.0f), std::sqrt(16.0f * 0.85f / 20.0f)), "over budget drops to the area that fits");
+    check(next(0.8f, 16.0f) < 0.8f, "just over the 95% line still drops");
+
+    // Plenty of headroom steps up slowly
+    check(near(next(0.6f, 10.0f), 0.65f), "under budget steps up");
+    check(near(next(0.98f, 10.0f), 1.0f), "stepping up stops at the maximum");
+    check(next(1.0f, 10.0f) == 1.0f, "at the maximum stays there");
+
+    // Between 75% and 95% of the budget is left alone
+    check(next(0.7f, 14.0f) == 0.7f, "inside the band holds");
+    check(next(0.7f, 12.0f) == 0.7f, "exactly 75% holds");
+
+    // Clamping
+    check(next(0.6f, 100.0f) == 0.5f, "far over budget stops at the minimum");
+    check(next(0.5f, 100.0f) == 0.5f, "at the minimum stays there");
+
+    // Changes too small to be worth a reallocation are ignored
+    check(next(0.505f, 100.0f) == 0.505f, "tiny drop to the minimum is ignored");
+    check(next(0.995f, 10.0f) == 0.995f, "tiny step to the maximum is ignored");
+
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include "TestContext.h"
+#include "frame_gl/data/FrameBufferPool.h"
+#include "frame_gl/data/RenderGraph.h"
+using namespace frame;
+
+//
+// The pool and the transient targets of the render graph make real frame buffers, so these
+// tests need a GL context.
+//
+
+namespace
+{
+    void test_pool() {
+        FrameBufferPool pool(2);
+
+        // Buffers are only made when nothing free fits
+        FrameBuffer* a = pool.acquire(ivec2(64));
+        check(pool.allocated() == 1 && pool.in_use() == 1, "first acquire makes a buffer");
+        FrameBuffer* b = pool.acquire(ivec2(128));
+        check(b != a && pool.allocated() == 2, "buffers in use aren't handed out twice");
+
+        // Released buffers go to the smallest request they fit
+        pool.release(a);
+        pool.release(b);
+        FrameBuffer* c = pool.acquire(ivec2(48));
+        check(c == a, "request is given the smallest free buffer it fits in");
+        check(c->size() == ivec2(48) && c->allocation() == ivec2(64), "reused buffer draws to part of its storage");
+        check(pool.allocated() == 2, "reuse doesn't make a buffer");
+
+        // Formats have to match exactly
+        FrameBuffer* d = pool.acquire(ivec2(64), Texture::RGBA16F);
+        check(d != a && d != b && pool.allocated() == 3, "different format makes a new buffer");
+        pool.release(c);
+        pool.release(d);
+
+        // Buffers left idle for longer than the limit are deleted
+        pool.next_frame();
+        pool.next_frame();
+        check(pool.allocated() == 3, "recently used buffers are kept");
+        pool.next_frame();
+        check(pool.allocated() == 0, "idle buffers are deleted");
+    }
+
+    void test_graph_aliasing() {
+        FrameBufferPool pool;
+        RenderGraph graph;
+
+        // Two intermediates, each drawn and then read by a pass on the screen
+        RenderGraph::Handle first = graph.create(ivec2(64));
+        RenderGraph::Handle second = graph.create(ivec2(64));
+        FrameBuffer* first_buffer = nullptr;
+        FrameBuffer* second_buffer = nullptr;
+        graph.add_pass("draw first", first, {}, [&]() { first_buffer = graph.buffer(first); });
+        graph.add_pass("use first", graph.screen(), { first }, []() {});
+        graph.add_pass("draw second", second, {}, [&]() { second_buffer = graph.buffer(second); });
+        graph.add_pass("use second", graph.screen(), { second }, []() {});
+        graph.execute(pool);
+
+        check(first_buffer != nullptr && first_buffer == second_buffer, "transients whose passes don't overlap share a buffer");
+        check(pool.allocated() == 1 && pool.in_use() == 0, "shared buffer goes back to the pool");
+
+        // The next frame takes it from the pool again
+        RenderGraph::Handle third = graph.create(ivec2(32));
+        FrameBuffer* third_buffer = nullptr;
+        graph.add_pass("draw third", third, {}, [&]() { third_buffer = graph.buffer(third); });
+        graph.add_pass("use third", graph.screen(), { third }, []() {});
+        graph.execute(pool);
+        check(third_buffer == first_buffer && pool.allocated() == 1, "later frames reuse pooled buffers");
+    }
+}
+
+int main() {
+    GLFWwindow* window = open_context();
+    if (!window) {
+        std::printf("skipped: no GL context\n");
+        return SKIPPED;
+    }
+
+    test_pool();
+    test_graph_aliasing();
+
+    close_context(window);
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
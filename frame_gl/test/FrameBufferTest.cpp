@@ -0,0 +1,43 @@
+#include <cstdio>
+#include "frame_gl/data/FrameBuffer.h"
+using namespace frame;
+
+//
+// How a frame buffer's storage follows its size is worked out without touching GL, so it
+// can be tested without a context.
+//
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* name) {
+        std::printf("%s: %s\n", condition ? "pass" : "FAIL", name);
+        if (!condition) ++failures;
+    }
+}
+
+int main() {
+    ivec2 allocation(100, 100);
+
+    // Growing
+    check(FrameBuffer::fit_allocation(allocation, ivec2(100, 100)) == allocation, "same size keeps the storage");
+    check(FrameBuffer::fit_allocation(allocation, ivec2(120, 80)) == ivec2(120, 100), "growing one side keeps the other");
+    check(FrameBuffer::fit_allocation(allocation, ivec2(200, 150)) == ivec2(200, 150), "growing both sides fits the size");
+
+    // Shrinking keeps the storage until more than half of it would go unused
+    check(FrameBuffer::fit_allocation(allocation, ivec2(90, 90)) == allocation, "shrinking a little keeps the storage");
+    check(FrameBuffer::fit_allocation(allocation, ivec2(100, 50)) == allocation, "using exactly half keeps the storage");
+    check(FrameBuffer::fit_allocation(allocation, ivec2(100, 49)) == ivec2(100, 49), "using under half gives storage back");
+    check(FrameBuffer::fit_allocation(allocation, ivec2(10, 10)) == ivec2(10, 10), "shrinking a lot fits the size");
+
+    // Growing one side while shrinking the other can leave most of the new storage unused too
+    check(FrameBuffer::fit_allocation(allocation, ivec2(300, 10)) == ivec2(300, 10), "long thin size isn't padded to the old height");
+
+    // Empty sizes, as minimized windows report, never give storage back
+    check(FrameBuffer::fit_allocation(allocation, ivec2(0, 0)) == allocation, "empty size keeps the storage");
+    check(FrameBuffer::fit_allocation(allocation, ivec2(0, 120)) == ivec2(100, 120), "empty width still grows the height");
+
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
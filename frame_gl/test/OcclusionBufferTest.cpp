@@ -0,0 +1,95 @@
+#include <cstdio>
+#include <glm/gtc/matrix_transform.hpp>
+#include "frame_gl/data/OcclusionBuffer.h"
+#include "frame_gl/math.h"
+using namespace frame;
+
+//
+// The occlusion buffer runs entirely on the CPU, so it can be tested without a GL context.
+// The camera sits at the origin looking down -z, with a 90 degree vertical field of view and
+// a 2:1 aspect ratio, so a point at distance d is on screen while |x| < 2d and |y| < d.
+// That puts it at pixel (128 + 64x/d, 64 + 64y/d) of the 256x128 buffer.
+//
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* name) {
+        std::printf("%s: %s\n", condition ? "pass" : "FAIL", name);
+        if (!condition) ++failures;
+    }
+
+    // A square facing the camera, centered on the view axis
+    void add_wall(OcclusionBuffer& buffer, float half_size, float distance) {
+        vec3 positions[] = {
+            vec3(-half_size, -half_size, -distance),
+            vec3( half_size, -half_size, -distance),
+            vec3( half_size,  half_size, -distance),
+            vec3(-half_size,  half_size, -distance),
+        };
+        ivec3 triangles[] = { ivec3(0, 1, 2), ivec3(0, 2, 3) };
+        buffer.add_occluder((const char*)positions, sizeof(vec3), 4, triangles, 2, mat4(1.0f));
+    }
+
+    bool box_visible(const OcclusionBuffer& buffer, const vec3& min, const vec3& max) {
+        return buffer.visible(min, max, mat4(1.0f));
+    }
+}
+
+int main() {
+    mat4 projection = glm::perspective(glm::radians(90.0f), 2.0f, 0.1f, 100.0f);
+    OcclusionBuffer buffer(ivec2(256, 128), 32);
+
+    // Nothing drawn yet, so everything in view is visible
+    buffer.begin(projection);
+    buffer.begin_rasterize();
+    buffer.finish();
+    check(box_visible(buffer, vec3(-1, -1, -21), vec3(1, 1, -19)), "empty buffer hides nothing");
+
+    // A wall 10 units across at distance 10 covers the middle quarter of the screen's width,
+    // and the middle half of its height
+    buffer.begin(projection);
+    add_wall(buffer, 5.0f, 10.0f);
+    check(buffer.occluder_triangles() == 2, "wall is binned");
+    buffer.begin_rasterize();
+    buffer.finish();
+
+    // Rasterization
+    check(buffer.depth(ivec2(128, 64)) < 1.0f, "wall covers the center");
+    check(buffer.depth(ivec2(80, 64)) == 1.0f, "wall leaves the left clear");
+    check(buffer.depth(ivec2(176, 64)) == 1.0f, "wall leaves the right clear");
+    check(buffer.depth(ivec2(128, 110)) == 1.0f, "wall leaves the top clear");
+    check(buffer.depth(ivec2(128, 64)) > 0.0f, "wall depth is past the near plane");
+
+    // Pyramid
+    size_t top = buffer.levels() - 1;
+    check(buffer.level_size(top) == ivec2(1, 1), "pyramid ends in a single texel");
+    check(buffer.depth(ivec2(0, 0), top) == 1.0f, "pyramid keeps the farthest depth");
+    check(buffer.depth(ivec2(32, 16), 2) == buffer.depth(ivec2(128, 64)), "pyramid inside the wall keeps its depth");
+
+    // Queries
+    check(!box_visible(buffer, vec3(-1, -1, -21), vec3(1, 1, -19)), "box behind the wall is occluded");
+    check(box_visible(buffer, vec3(-1, -1, -6), vec3(1, 1, -4)), "box in front of the wall is visible");
+    check(box_visible(buffer, vec3(5, -1, -21), vec3(15, 1, -19)), "box partly behind the side of the wall is visible");
+    check(box_visible(buffer, vec3(-1, 5, -21), vec3(1, 15, -19)), "box partly behind the top of the wall is visible");
+    check(!box_visible(buffer, vec3(100, -1, -11), vec3(102, 1, -9)), "box outside the view is culled");
+    check(box_visible(buffer, vec3(-1, -1, -1), vec3(1, 1, 1)), "box around the camera is visible");
+    check(box_visible(buffer, vec3(-0.5f, -0.5f, -20), vec3(0.5f, 0.5f, -0.05f)), "box crossing the near plane is visible");
+
+    // Occluders crossing the camera plane are skipped rather than clipped
+    buffer.begin(projection);
+    add_wall(buffer, 5.0f, 10.0f);
+    vec3 crossing[] = { vec3(-1, -1, 1), vec3(1, -1, 1), vec3(0, 1, -5) };
+    ivec3 crossing_triangle[] = { ivec3(0, 1, 2) };
+    buffer.add_occluder((const char*)crossing, sizeof(vec3), 3, crossing_triangle, 1, mat4(1.0f));
+    check(buffer.occluder_triangles() == 2, "occluder crossing the camera plane is skipped");
+
+    // Results don't depend on anything left over from the last frame
+    buffer.begin_rasterize();
+    buffer.finish();
+    check(!box_visible(buffer, vec3(-1, -1, -21), vec3(1, 1, -19)), "second frame gives the same result");
+
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
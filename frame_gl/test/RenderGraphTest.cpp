@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "frame_gl/data/RenderGraph.h"
+using namespace frame;
+
+//
+// Culling and ordering only look at handles, so they're tested through plan() without a GL
+// context. Imported buffers are only used as keys there, so any distinct pointers stand in for them.
+//
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* name) {
+        std::printf("%s: %s\n", condition ? "pass" : "FAIL", name);
+        if (!condition) ++failures;
+    }
+
+    int storage[2];
+    FrameBuffer* const first_buffer = reinterpret_cast<FrameBuffer*>(&storage[0]);
+    FrameBuffer* const second_buffer = reinterpret_cast<FrameBuffer*>(&storage[1]);
+
+    void nothing() {}
+
+    bool plan_is(const RenderGraph& graph, const std::vector<std::string>& names) {
+        return graph.plan() == names;
+    }
+
+    void test_culling() {
+        RenderGraph graph;
+        RenderGraph::Handle used = graph.create(ivec2(64));
+        RenderGraph::Handle unused = graph.create(ivec2(64));
+        RenderGraph::Handle feeds_unused = graph.create(ivec2(64));
+        RenderGraph::Handle imported = graph.import(first_buffer);
+
+        graph.add_pass("draw used", used, {}, nothing);
+        graph.add_pass("draw feeds unused", feeds_unused, {}, nothing);
+        graph.add_pass("draw unused", unused, { feeds_unused }, nothing);
+        graph.add_pass("draw imported", imported, {}, nothing);
+        graph.add_pass("present", graph.screen(), { used }, nothing);
+
+        check(plan_is(graph, { "draw used", "draw imported", "present" }), "passes nothing reads are culled, with what only they read");
+
+        // A read after the last write doesn't keep the write before it alive
+        RenderGraph late;
+        RenderGraph::Handle target = late.create(ivec2(64));
+        late.add_pass("present early", late.screen(), { target }, nothing);
+        late.add_pass("draw late", target, {}, nothing);
+        check(plan_is(late, { "present early" }), "writes only read before they happen are culled");
+    }
+
+    void test_ordering() {
+        RenderGraph graph;
+        RenderGraph::Handle first = graph.import(first_buffer);
+        RenderGraph::Handle second = graph.import(second_buffer);
+        check(graph.import(first_buffer) == first, "importing a buffer twice gives the same handle");
+
+        graph.add_pass("first 1", first, {}, nothing);
+        graph.add_pass("second 1", second, {}, nothing);
+        graph.add_pass("first 2", first, {}, nothing);
+        graph.add_pass("second 2", second, {}, nothing);
+        check(plan_is(graph, { "first 1", "first 2", "second 1", "second 2" }), "passes on the same target run back to back");
+
+        // A pass can't jump ahead of one reading what it's about to draw over
+        RenderGraph reads;
+        first = reads.import(first_buffer);
+        second = reads.import(second_buffer);
+        reads.add_pass("first 1", first, {}, nothing);
+        reads.add_pass("second reads first", second, { first }, nothing);
+        reads.add_pass("first 2", first, {}, nothing);
+        check(plan_is(reads, { "first 1", "second reads first", "first 2" }), "drawing over a target waits for its readers");
+
+        // Nor ahead of the pass drawing what it reads
+        RenderGraph writes;
+        first = writes.import(first_buffer);
+        second = writes.import(second_buffer);
+        writes.add_pass("first 1", first, {}, nothing);
+        writes.add_pass("second 1", second, {}, nothing);
+        writes.add_pass("first reads second", first, { second }, nothing);
+        check(plan_is(writes, { "first 1", "second 1", "first reads second" }), "reading a target waits for its writers");
+    }
+
+    void test_execute() {
+        FrameBufferPool pool;
+        RenderGraph graph;
+
+        // Passes on the screen and culled passes never touch a frame buffer
+        std::vector<std::string> ran;
+        RenderGraph::Handle unused = graph.create(ivec2(64));
+        graph.add_pass("unused", unused, {}, [&]() { ran.push_back("unused"); });
+        graph.add_pass("screen", graph.screen(), {}, [&]() {
+            ran.push_back("screen");
+            graph.add_pass("late", graph.screen(), {}, [&]() { ran.push_back("late"); });
+        });
+        graph.execute(pool);
+
+        check(ran == std::vector<std::string>({ "screen" }), "only live passes run");
+        check(graph.passes_run() == 1 && graph.passes_culled() == 1, "run and culled passes are counted");
+        check(graph.empty() && graph.plan().empty(), "passes added while running are dropped");
+        check(pool.allocated() == 0, "culled transients never take a buffer");
+    }
+}
+
+int main() {
+    test_culling();
+    test_ordering();
+    test_execute();
+
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+#include <cstdio>
+#include "frame_gl/data/Shader.h"
+using namespace frame;
+
+//
+// Cached program binaries are looked up by a hash of everything which went into them. Parts
+// are only compiled when their id is first asked for, so none of this needs a GL context.
+//
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* name) {
+        std::printf("%s: %s\n", condition ? "pass" : "FAIL", name);
+        if (!condition) ++failures;
+    }
+
+    const std::vector<std::string> driver = { "Vendor", "Renderer", "4.6.0" };
+
+    std::vector< Resource<ShaderPart> > parts(const std::string& vertex, const std::string& fragment) {
+        return {
+            Resource<ShaderPart>(ShaderPart::Type::Vertex, vertex),
+            Resource<ShaderPart>(ShaderPart::Type::Fragment, fragment)
+        };
+    }
+}
+
+int main() {
+    std::string name = Shader::cache_name(driver, parts("vertex", "fragment"));
+
+    check(name.size() == 20 && name.substr(16) == ".bin", "name is a 64 bit hash in hex");
+    check(Shader::cache_name(driver, parts("vertex", "fragment")) == name, "same inputs give the same name");
+
+    // Anything which changes the program changes the name
+    check(Shader::cache_name(driver, parts("vertex", "fragment2")) != name, "source changes the name");
+    check(Shader::cache_name(driver, parts("fragment", "vertex")) != name, "part order changes the name");
+    check(Shader::cache_name(driver, {
+        Resource<ShaderPart>(ShaderPart::Type::Vertex, "vertex"),
+        Resource<ShaderPart>(ShaderPart::Type::Geometry, "fragment")
+    }) != name, "part type changes the name");
+    check(Shader::cache_name(driver, {
+        Resource<ShaderPart>(ShaderPart::Type::Vertex, std::vector<std::string>({ "ver", "tex" })),
+        Resource<ShaderPart>(ShaderPart::Type::Fragment, "fragment")
+    }) != name, "splitting a source differently changes the name");
+
+    // So does the driver, whose binaries no other driver can load
+    check(Shader::cache_name({ "Vendor", "Renderer", "4.6.1" }, parts("vertex", "fragment")) != name, "driver version changes the name");
+    check(Shader::cache_name({ "Vendor", "Renderer4.6.0", "" }, parts("vertex", "fragment")) != name, "driver strings aren't run together");
+
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#define GLEW_STATIC
+#include <cstdio>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+//
+// Tests of the parts which need GL get their context from a hidden window. Machines without a
+// display can't make one, so those tests report themselves as skipped to ctest instead.
+//
+
+namespace
+{
+    const int SKIPPED = 77;
+
+    int failures = 0;
+
+    void check(bool condition, const char* name) {
+        std::printf("%s: %s\n", condition ? "pass" : "FAIL", name);
+        if (!condition) ++failures;
+    }
+
+    GLFWwindow* open_context() {
+        if (!glfwInit())
+            return nullptr;
+
+        glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+        GLFWwindow* window = glfwCreateWindow(64, 64, "test", 0, 0);
+        if (!window) {
+            glfwTerminate();
+            return nullptr;
+        }
+
+        glfwMakeContextCurrent(window);
+        if (glewInit() != GLEW_OK) {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            return nullptr;
+        }
+        return window;
+    }
+
+    void close_context(GLFWwindow* window) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+}
@@ -0,0 +1,73 @@
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "frame_gl/parallel.h"
+using namespace frame;
+
+//
+// Batches are shared out between threads, and helpers holding the generation of an older
+// batch have to find nothing left to claim, rather than claim items of the new one.
+//
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* name) {
+        std::printf("%s: %s\n", condition ? "pass" : "FAIL", name);
+        if (!condition) ++failures;
+    }
+}
+
+int main() {
+    WorkQueue queue;
+
+    // One thread takes every item of a batch in order
+    unsigned int generation = queue.open(3);
+    std::vector<size_t> claimed;
+    queue.drain(generation, [&claimed](size_t index) { claimed.push_back(index); });
+    queue.wait();
+    check(claimed == std::vector<size_t>({ 0, 1, 2 }), "drain claims every item once, in order");
+
+    size_t index;
+    check(!queue.claim(generation, index), "finished batch has nothing left to claim");
+
+    // A helper left over from the last batch doesn't take items of the next
+    unsigned int stale = generation;
+    generation = queue.open(2);
+    check(generation != stale, "each batch has a new generation");
+    check(!queue.claim(stale, index), "stale generation claims nothing");
+    check(queue.claim(generation, index) && index == 0, "current generation claims the first item");
+    queue.complete();
+    queue.drain(generation, [](size_t) {});
+    queue.wait();
+
+    // An empty batch is already finished
+    generation = queue.open(0);
+    queue.wait();
+    check(!queue.claim(generation, index), "empty batch has nothing to claim");
+
+    // Several threads share a batch, and every item is done exactly once
+    const size_t COUNT = 10000;
+    std::vector< std::atomic<int> > done(COUNT);
+    for (auto& item : done)
+        item = 0;
+    generation = queue.open(COUNT);
+    auto work = [&done](size_t index) { ++done[index]; };
+    std::vector<std::thread> helpers;
+    for (int i = 0; i < 3; ++i)
+        helpers.push_back(std::thread([&queue, generation, work]() { queue.drain(generation, work); }));
+    queue.drain(generation, work);
+    queue.wait();
+    for (auto& helper : helpers)
+        helper.join();
+
+    bool once = true;
+    for (auto& item : done)
+        once = once && item == 1;
+    check(once, "items shared between threads are each done once");
+
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}